@@ -8,7 +8,23 @@
  * @version 0.4 2022-06-12 Small bug fix where updating the FU mode doesn't always return the baudrate update. Only if it changed.
  * @version 0.5 2022-06-13 Added size_t write(*buffer, size) override to support writing whole buffers at once.
  * @version 0.5 2022-06-14 Added flush override.
- * @date 2022-06-14
+ * @version 0.6 2026-10-17 Added airtime model and energy accounting per module state.
+ * @version 0.7 2026-10-17 Added priority transmit queues drained by a pacer in `poll()`, with `kMaxFrameSize` as the size limit of a queued frame.
+ * @version 0.8 2026-10-17 Added receive ring buffer with zero copy frame views.
+ * @version 0.9 2026-10-17 Added scatter gather `writev` and `Enqueue` with an optional CRC-16.
+ * @version 0.10 2026-10-17 Added bulk `readBytes`, `readBytesUntil` and multi byte `peek` overrides, `peek` only moves data into the receive ring.
+ * @version 0.11 2026-10-17 Added `availableForWrite` override based on the model of the module buffer.
+ * @version 0.12 2026-10-17 Added `onByte`, `onPacket` and `onCommandComplete` callbacks in a fixed size table.
+ * @version 0.13 2026-10-17 Added `Deadline` that bounds every blocking call, reads are bounded as a whole.
+ * @version 0.14 2026-10-17 Command mode operations run as a non-blocking state machine driven by `poll()`.
+ * @version 0.15 2026-10-17 Added coroutine versions of the command mode operations and packet reads (see HC12Async.h).
+ * @version 0.16 2026-10-17 Data received while entering command mode is kept in the receive ring instead of dropped.
+ * @version 0.17 2026-10-17 Command mode sessions wait for a gap in the traffic before the SET pin goes low.
+ * @version 0.18 2026-10-17 Added `airFlush` that models when the module has sent everything over the air, after the UART drain.
+ * @version 0.19 2026-10-17 The parameters are kept in a packed `Config` word with a dirty mask instead of four `Updatable`s, every parameter is validated and the `Prepare*` functions report invalid values.
+ * @version 0.20 2026-10-17 AT commands and their replies are described in one table instead of a handler per command.
+ * @version 0.21 2026-10-17 `begin` can detect the firmware version (`AT+V`) and use `AT+RX` and measured reply times, with the basic capabilities as fallback.
+ * @date 2026-10-17
  *
  * @copyright Copyright (c) 2022
  *
@@ -29,383 +45,1559 @@
 #define LOG(x)
 #endif
 
-HC12::HC12(Stream &serial, unsigned int setPin, Baudrates baud, OperationalMode mode, unsigned int channel, TransmitPower power) : serial(serial), setPin(setPin),
-                                                                                                                                   baudrate((int)baud),
-                                                                                                                                   operationalMode(OperationalMode::FU3),
-                                                                                                                                   channel(1),
-                                                                                                                                   transmitPower(TransmitPower::mW_100_0)
+template <>
+const uint8_t HC12BuildLayout::kCheck = 0;
+
+HC12::HC12(Stream &serial, unsigned int setPin, Baudrates baud, OperationalMode mode, unsigned int channel, TransmitPower power,
+           const uint8_t &layout) : serial(serial), setPin(setPin),
+                                                                                                                                   config(baud, mode, channel, power),
+                                                                                                                                   pendingConfig(baud, mode, channel, power),
+                                                                                                                                   dirtyConfig(0),
+                                                                                                                                   activeQueue(0),
+                                                                                                                                   activeRemaining(0),
+                                                                                                                                   uartBusy(0),
+                                                                                                                                   airBusy(0),
+                                                                                                                                   transmitUpdated(0),
+                                                                                                                                   receiveHead(0),
+                                                                                                                                   receiveCount(0),
+                                                                                                                                   frameHead(0),
+                                                                                                                                   frameCount(0),
+                                                                                                                                   openFrameLength(0),
+                                                                                                                                   lastReceive(0),
+                                                                                                                                   savedBytes(0),
+                                                                                                                                   handlerSequence(0),
+                                                                                                                                   commandDeadline(Deadline::Never()),
+                                                                                                                                   commandState(CommandState::Idle),
+                                                                                                                                   commandStep(CommandStep::Check),
+                                                                                                                                   commandLastStep(CommandStep::Check),
+                                                                                                                                   commandSuccess(false),
+                                                                                                                                   commandSessionStart(0),
+                                                                                                                                   commandStateStart(0),
+                                                                                                                                   commandTimeout(0),
+                                                                                                                                   commandReplyLength(0),
+                                                                                                                                   commandReplyLines(0),
+                                                                                                                                   commandDirty(0),
+                                                                                                                                   commandReported(0),
+                                                                                                                                   capabilities{0, 0, false, 0}
 {
+    for (EventHandler &handler : this->handlers)
+    {
+        handler.type = EventType::None;
+    }
+    // Only there so the caller refers to the layout it was compiled with.
+    (void)layout;
     pinMode(setPin, OUTPUT_OPEN_DRAIN);
+    this->ResetEnergyStats();
 }
 
 bool HC12::begin()
 {
-    CommandMode cmd(this->setPin);
-    bool result = SendCommandAndGetOK("AT");
-    return result;
+    return this->begin(Deadline::Never());
 }
 
-void HC12::PrepareBaudrate(HC12::Baudrates baudrate)
+bool HC12::begin(Deadline deadline, bool detectCapabilities)
 {
-    if (IsBaudrate(baudrate))
-    {
-        this->baudrate.New() = (int)baudrate;
-    }
+    this->ResetEnergyStats();
+    CommandStep last = detectCapabilities ? CommandStep::RequestVersion : CommandStep::Check;
+    return this->BeginCommandSession(CommandStep::Check, last, deadline) && this->WaitForCommandSession();
 }
 
-void HC12::PrepareOperationalMode(HC12::OperationalMode mode)
+HC12::Capabilities HC12::GetCapabilities() const
 {
-    this->operationalMode.New() = mode;
+    return this->capabilities;
 }
 
-void HC12::PrepareChannel(int channel)
+void HC12::SetCapabilities(const Capabilities &capabilities)
 {
-    this->channel.New() = channel;
+    this->capabilities = capabilities;
 }
 
-void HC12::PrepareTransmitPower(HC12::TransmitPower power)
+bool HC12::PrepareBaudrate(HC12::Baudrates baudrate)
 {
-    this->transmitPower.New() = power;
+    if (!SetConfigValue(this->pendingConfig, Config::kBaudrate, (long)baudrate))
+    {
+        return false;
+    }
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    return true;
 }
 
-bool HC12::UpdateParams()
+bool HC12::PrepareOperationalMode(HC12::OperationalMode mode)
 {
-    CommandMode cmd(this->setPin);
-    bool success = true;
-    if (this->transmitPower.HasChanged() && !this->UpdateBaudrate())
+    if (!SetConfigValue(this->pendingConfig, Config::kOperationalMode, (long)mode))
     {
-        LOG("Baudrate update failure 1.");
-        success = false;
+        return false;
     }
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    return true;
+}
 
-    if (this->channel.HasChanged() && !this->UpdateChannel())
-    {
-        LOG("Channel update failure 1.");
-        success = false;
-    }
-    if (!this->channel.HasChanged() && !this->RequestChannel())
-    {
-        LOG("Channel update failure 2.");
-        success = false;
-    }
-    if (this->transmitPower.HasChanged() && !this->UpdateTransmitPower())
-    {
-        LOG("Transmit power update failure 1.");
-        success = false;
-    }
-    if (!this->transmitPower.HasChanged() && !this->RequestTransmitPower())
+bool HC12::PrepareChannel(int channel)
+{
+    if (!SetConfigValue(this->pendingConfig, Config::kChannel, channel))
     {
-        LOG("Request transmit power update failure 2.");
-        success = false;
+        return false;
     }
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    return true;
+}
 
-    // Update this one after updating the baud rate because not all modes support all baudrates and setting a mode
-    // will forcefully change the baudrate to a supported one.
-    if (this->operationalMode.HasChanged() && !this->UpdateOperationalMode())
-    {
-        LOG("Operational mode update failure 1.");
-        success = false;
-    }
-    if (!this->operationalMode.HasChanged() && !this->RequestOperationalMode())
+bool HC12::PrepareTransmitPower(HC12::TransmitPower power)
+{
+    if (!SetConfigValue(this->pendingConfig, Config::kTransmitPower, (long)power))
     {
-        LOG("Operational mode update failure 2.");
-        success = false;
+        return false;
     }
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    return true;
+}
 
-    if (!this->baudrate.HasChanged() && !this->RequestBaudrate())
+bool HC12::PrepareConfig(const Config &config)
+{
+    if (!config.IsValid())
     {
-        LOG("Baudrate update failure 2.");
-        success = false;
+        return false;
     }
-    return success;
+    this->pendingConfig = config;
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    return true;
+}
+
+bool HC12::UpdateParams()
+{
+    return this->UpdateParams(Deadline::Never());
+}
+
+bool HC12::UpdateParams(Deadline deadline)
+{
+    return this->BeginUpdateParams(deadline) && this->WaitForCommandSession();
+}
+
+bool HC12::BeginUpdateParams(Deadline deadline)
+{
+    return this->BeginCommandSession(CommandStep::UpdateBaudrate, CommandStep::RequestAll, deadline);
 }
 
 unsigned int HC12::GetBaudrate()
 {
-    return this->baudrate.Current();
+    return (unsigned int)this->config.Baudrate();
 }
 
 HC12::OperationalMode HC12::GetOperationalMode()
 {
-    return this->operationalMode.Current();
+    return this->config.Mode();
 }
 
 unsigned int HC12::GetChannel()
 {
-    return this->channel.Current();
+    return this->config.Channel();
 }
 
 HC12::TransmitPower HC12::GetTransmitPower()
 {
-    return this->transmitPower.Current();
+    return this->config.Power();
+}
+
+HC12::Config HC12::GetConfig() const
+{
+    return this->config;
 }
 
 bool HC12::Sleep()
 {
-    CommandMode cmd(this->setPin);
-    return this->SendCommandAndGetResult("AT+SLEEP") == "AT+SLEEP";
+    return this->Sleep(Deadline::Never());
+}
+
+bool HC12::Sleep(Deadline deadline)
+{
+    return this->BeginSleep(deadline) && this->WaitForCommandSession();
+}
+
+bool HC12::BeginSleep(Deadline deadline)
+{
+    return this->BeginCommandSession(CommandStep::Sleep, CommandStep::Sleep, deadline);
 }
 
 bool HC12::Reset()
 {
-    CommandMode cmd(this->setPin);
-    String result = this->SendCommandAndGetResult("AT+DEFAULT");
-    bool success = (result == "OK+DEFAULT");
-    if (success)
-    {
-        this->baudrate = Updatable<unsigned int>(9600);
-        this->channel = Updatable<int>(1);
-        this->transmitPower = Updatable<TransmitPower>(TransmitPower::mW_100_0);
-        this->operationalMode = Updatable<OperationalMode>(OperationalMode::FU3);
-        LOG("Reset was successful.");
-    }
-    return success;
+    return this->Reset(Deadline::Never());
 }
 
-int HC12::available()
+bool HC12::Reset(Deadline deadline)
 {
-    return this->serial.available();
+    return this->BeginReset(deadline) && this->WaitForCommandSession();
 }
 
-int HC12::read()
+bool HC12::BeginReset(Deadline deadline)
 {
-    return this->serial.read();
+    return this->BeginCommandSession(CommandStep::Reset, CommandStep::Reset, deadline);
 }
 
-int HC12::peek()
+bool HC12::IsCommandBusy() const
 {
-    return this->serial.peek();
+    return this->commandState != CommandState::Idle;
 }
 
-size_t HC12::write(uint8_t data)
+bool HC12::LastCommandSucceeded() const
 {
-    return this->serial.write(data);
+    return this->commandSuccess;
 }
 
-size_t HC12::write(const uint8_t *buffer, size_t size)
+unsigned long HC12::GetByteAirtime() const
 {
-    return this->serial.write(buffer, size);
+    // Air data rates from the datasheet, FU3 adjusts its air rate to the serial baudrate.
+    unsigned long airBaudrate = 250000UL;
+    unsigned int baud = (unsigned int)this->config.Baudrate();
+    switch (this->config.Mode())
+    {
+    case OperationalMode::FU1:
+    case OperationalMode::FU2:
+        airBaudrate = 250000UL;
+        break;
+    case OperationalMode::FU3:
+        if (baud == (unsigned int)Baudrates::BPS_57600 || baud == (unsigned int)Baudrates::BPS_115200)
+            airBaudrate = 236000UL;
+        else if (baud >= (unsigned int)Baudrates::BPS_19200)
+            airBaudrate = 58000UL;
+        else if (baud >= (unsigned int)Baudrates::BPS_4800)
+            airBaudrate = 15000UL;
+        else
+            airBaudrate = 5000UL;
+        break;
+    case OperationalMode::FU4:
+        airBaudrate = 500UL;
+        break;
+    }
+    // 10 bits per byte, the same as the start and stop bit framing on the serial side.
+    return 10000000UL / airBaudrate;
 }
 
-void HC12::flush()
+void HC12::SetEnergyProfile(const EnergyProfile &profile)
 {
-    this->serial.flush();
+    this->energyProfile = profile;
 }
 
-bool HC12::SendCommandAndGetOK(Stream &serial, const String &command)
+HC12::EnergyStats HC12::GetEnergyStats() const
 {
-    String response = SendCommandAndGetResult(serial, command);
-    return response == "OK";
+    EnergyStats stats;
+    unsigned long now = millis();
+    stats.transmitMillis = this->transmitTime.millis;
+    stats.receiveMillis = this->receiveTime.millis;
+    stats.commandMillis = this->commandMillis;
+    stats.sleepMillis = this->sleepMillis;
+    if (this->sleeping)
+    {
+        stats.sleepMillis += now - this->sleepStart;
+    }
+    stats.bytesTransmitted = this->bytesTransmitted;
+    stats.bytesReceived = this->bytesReceived;
+
+    stats.idleMillis = this->IdleMillis(now);
+
+    // Charge in micro ampere * milli second, the transmit and idle charge are accumulated at the power and mode they
+    // were in, only the idle time since the last mode change is priced at the current mode.
+    unsigned long idleSince = (stats.idleMillis > this->idleAccounted) ? stats.idleMillis - this->idleAccounted : 0;
+    float charge = this->transmitCharge + this->idleCharge;
+    charge += (float)this->energyProfile.receiveMicroamp * stats.receiveMillis;
+    charge += (float)this->energyProfile.idleMicroamp[(int)this->config.Mode() - 1] * idleSince;
+    charge += (float)this->energyProfile.sleepMicroamp * stats.sleepMillis;
+    charge += (float)this->energyProfile.commandMicroamp * stats.commandMillis;
+    stats.energyMillijoule = charge * this->energyProfile.supplyMillivolt / 1.0e9f;
+    return stats;
 }
 
-String HC12::SendCommandAndGetResult(Stream &serial, const String &command)
+void HC12::ResetEnergyStats()
 {
-    SendCommand(serial, command);
-    auto oldTimeout = serial.getTimeout();
-    serial.setTimeout(kMaxCommandResponseTime);
-    String response = serial.readStringUntil('\n');
-    response.trim();
-    serial.setTimeout(oldTimeout);
-    return response;
+    this->energyStart = millis();
+    this->transmitTime = Airtime();
+    this->receiveTime = Airtime();
+    this->commandMillis = 0;
+    this->sleepMillis = 0;
+    this->sleepStart = this->energyStart;
+    this->sleeping = false;
+    this->transmitCharge = 0.0f;
+    this->idleCharge = 0.0f;
+    this->idleAccounted = 0;
+    this->bytesTransmitted = 0;
+    this->bytesReceived = 0;
+    this->savedBytes = 0;
 }
 
-void HC12::SendCommand(Stream &serial, const String &command)
+bool HC12::Enqueue(const uint8_t *buffer, size_t size, uint8_t priority)
 {
-    // Drop old data since in command mode this can't be valid userdata anymore.
-    while (serial.available())
+    if (priority > kLowestPriority)
     {
-        serial.read();
+        return false;
     }
-    serial.write(command.c_str());
-    serial.write('\r');
-    serial.write('\n');
+    return this->transmitQueues[priority].Push(buffer, size);
 }
 
-bool HC12::UpdateBaudrate()
+bool HC12::Enqueue(const WriteSpan *spans, size_t count, uint8_t priority, bool appendCrc)
 {
-    const String kBaudrateString = String(this->baudrate.New());
-    String result = this->SendCommandAndGetResult("AT+B" + kBaudrateString);
-    bool success = (result == ("OK+B" + kBaudrateString));
-    if (success)
+    if (priority > kLowestPriority)
     {
-        this->baudrate.MarkUpdated();
+        return false;
     }
-    else
+    size_t size = appendCrc ? 2 : 0;
+    for (size_t i = 0; i < count; i++)
     {
-        LOG("Received baudrate confirmation in baudrate update wasn't a known supported value. Response was: " + result + ".");
+        size += spans[i].length;
     }
-    return success;
+    TransmitQueue &queue = this->transmitQueues[priority];
+    if (!queue.Begin(size))
+    {
+        return false;
+    }
+    uint16_t crc = HC12Crc16::kInitial;
+    for (size_t i = 0; i < count; i++)
+    {
+        queue.Append(spans[i].data, spans[i].length);
+        if (appendCrc)
+        {
+            crc = HC12Crc16::Update(crc, spans[i].data, spans[i].length);
+        }
+    }
+    if (appendCrc)
+    {
+        const uint8_t crcBytes[2] = {(uint8_t)(crc >> 8), (uint8_t)(crc & 0xFF)};
+        queue.Append(crcBytes, sizeof(crcBytes));
+    }
+    return true;
+}
+
+size_t HC12::writev(const WriteSpan *spans, size_t count, bool appendCrc)
+{
+    size_t written = 0;
+    uint16_t crc = HC12Crc16::kInitial;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t spanWritten = this->write(spans[i].data, spans[i].length);
+        written += spanWritten;
+        if (appendCrc)
+        {
+            crc = HC12Crc16::Update(crc, spans[i].data, spanWritten);
+        }
+        if (spanWritten != spans[i].length)
+        {
+            return written;
+        }
+    }
+    if (appendCrc)
+    {
+        const uint8_t crcBytes[2] = {(uint8_t)(crc >> 8), (uint8_t)(crc & 0xFF)};
+        written += this->write(crcBytes, sizeof(crcBytes));
+    }
+    return written;
 }
 
-bool HC12::RequestBaudrate()
+bool HC12::IsTransmitQueueEmpty() const
 {
-    String result = this->SendCommandAndGetResult("AT+RB");
-    if (result.startsWith("OK+B") == false)
+    if (this->activeRemaining != 0)
     {
-        LOG("Baudrate receive request didn't start with OK+B. Response was: " + result + ".");
         return false;
     }
-    result.remove(0, 4);
-    int baud = result.toInt();
-    bool success = IsBaudrate((Baudrates)baud);
-    if (success)
+    for (uint8_t i = 0; i < HC12_TX_PRIORITIES; i++)
     {
-        this->baudrate.ForceUpdateCurrent(baud);
+        if (!this->transmitQueues[i].Empty())
+        {
+            return false;
+        }
     }
-    else
+    return true;
+}
+
+void HC12::poll()
+{
+    this->PumpCommand();
+    if (this->IsInCommandMode())
     {
-        LOG("Received baudrate wasn't a known supported value. Value was: " + String(baud) + ".");
+        return;
     }
+    this->PumpReceive();
+    this->PumpTransmitQueues();
+}
 
-    return success;
+uint8_t HC12::FramesAvailable() const
+{
+    return this->frameCount;
 }
 
-bool HC12::UpdateOperationalMode()
+bool HC12::PeekFrame(FrameView &view) const
 {
-    const String kPowerModeString = String((int)this->operationalMode.New());
-    String result = this->SendCommandAndGetResult("AT+FU" + kPowerModeString);
-    if (result.startsWith("OK+FU") == false)
+    if (this->frameCount == 0)
     {
-        LOG("FU update command reply didn't start with AT+FU but was: " + result + ".");
         return false;
     }
-    result.remove(0, 5);
-    OperationalMode power = (OperationalMode)result.substring(0, 1).toInt();
-    bool power_success = IsOperationalMode(power);
-    if (power_success)
+    size_t length = this->frameLengths[this->frameHead];
+    size_t contiguous = HC12_RX_BUFFER_SIZE - this->receiveHead;
+    view.first = &this->receiveBuffer[this->receiveHead];
+    view.firstLength = (length < contiguous) ? length : contiguous;
+    view.second = this->receiveBuffer;
+    view.secondLength = length - view.firstLength;
+    return true;
+}
+
+void HC12::ReleaseFrame()
+{
+    if (this->frameCount > 0)
+    {
+        this->ConsumeReceived(this->frameLengths[this->frameHead]);
+    }
+}
+
+void HC12::PumpReceive()
+{
+    this->ReceiveAvailable();
+
+    if (this->openFrameLength > 0)
+    {
+        // A full ring buffer also ends the frame, otherwise nothing could ever be released to make room.
+        if (this->receiveCount == HC12_RX_BUFFER_SIZE || micros() - this->lastReceive >= this->FrameGap())
+        {
+            this->CloseOpenFrame();
+        }
+    }
+    this->DispatchPackets();
+}
+
+unsigned long HC12::FrameGap() const
+{
+    unsigned long gap = kFrameGapBytes * 10000000UL / (unsigned long)this->config.Baudrate();
+    return (gap < kMinFrameGap) ? kMinFrameGap : gap;
+}
+
+size_t HC12::ReceiveAvailable()
+{
+    size_t received = 0;
+    while (this->receiveCount < HC12_RX_BUFFER_SIZE && this->serial.available() > 0)
+    {
+        int data = this->serial.read();
+        if (data < 0)
+        {
+            break;
+        }
+        this->receiveBuffer[(this->receiveHead + this->receiveCount) % HC12_RX_BUFFER_SIZE] = (uint8_t)data;
+        this->receiveCount++;
+        this->openFrameLength++;
+        this->lastReceive = micros();
+        this->AccountReceive(1);
+        received++;
+        unsigned long dispatch = this->handlerSequence;
+        for (const EventHandler &entry : this->handlers)
+        {
+            if (this->IsHandlerActive(entry, EventType::Byte, dispatch))
+            {
+                entry.function.onByte((uint8_t)data, entry.context);
+            }
+        }
+    }
+    return received;
+}
+
+void HC12::CloseOpenFrame()
+{
+    if (this->openFrameLength > 0 && this->frameCount < HC12_RX_MAX_FRAMES)
+    {
+        this->frameLengths[(this->frameHead + this->frameCount) % HC12_RX_MAX_FRAMES] = this->openFrameLength;
+        this->frameCount++;
+        this->openFrameLength = 0;
+    }
+}
+
+void HC12::SaveReceived()
+{
+    this->savedBytes += this->ReceiveAvailable();
+}
+
+void HC12::ConsumeReceived(size_t size)
+{
+    this->receiveHead = (this->receiveHead + size) % HC12_RX_BUFFER_SIZE;
+    this->receiveCount -= size;
+    // Complete frames are always in front of the frame that is still being received.
+    while (size > 0 && this->frameCount > 0)
+    {
+        size_t &length = this->frameLengths[this->frameHead];
+        size_t consumed = (size < length) ? size : length;
+        length -= consumed;
+        size -= consumed;
+        if (length == 0)
+        {
+            this->frameHead = (this->frameHead + 1) % HC12_RX_MAX_FRAMES;
+            this->frameCount--;
+        }
+    }
+    this->openFrameLength -= size;
+}
+
+void HC12::PumpTransmitQueues()
+{
+    while (true)
     {
-        this->operationalMode.MarkUpdated();
+        // Keep only a little in the module and the UART: a frame that comes later may have a higher priority, and a
+        // full UART would make `write` block.
+        unsigned int backlog = this->ModuleBacklog();
+        unsigned int uartBacklog = this->UartBacklog();
+        if (backlog >= kTransmitLowWatermark || uartBacklog >= kSerialBufferSize)
+        {
+            return;
+        }
+        size_t room = kTransmitLowWatermark - backlog;
+        if (room > kSerialBufferSize - uartBacklog)
+            room = kSerialBufferSize - uartBacklog;
+
+        if (this->activeRemaining == 0)
+        {
+            // Frame boundary, so pick the highest priority that has something to send.
+            uint8_t priority = 0;
+            while (priority < HC12_TX_PRIORITIES && this->transmitQueues[priority].Empty())
+            {
+                priority++;
+            }
+            if (priority == HC12_TX_PRIORITIES)
+            {
+                return;
+            }
+            this->activeQueue = priority;
+            this->activeRemaining = this->transmitQueues[priority].PopLength();
+            continue;
+        }
+
+        TransmitQueue &queue = this->transmitQueues[this->activeQueue];
+        const uint8_t *data = nullptr;
+        size_t size = queue.Front(data);
+        if (size > this->activeRemaining)
+            size = this->activeRemaining;
+        if (size > room)
+            size = room;
+        size_t written = this->write(data, size);
+        queue.Consume(written);
+        this->activeRemaining -= written;
+        if (written != size)
+        {
+            return;
+        }
     }
-    else
+}
+
+void HC12::UpdateTransmitModel()
+{
+    unsigned long now = micros();
+    unsigned long elapsed = now - this->transmitUpdated;
+    this->transmitUpdated = now;
+    this->uartBusy = (elapsed < this->uartBusy) ? this->uartBusy - elapsed : 0;
+    this->airBusy = (elapsed < this->airBusy) ? this->airBusy - elapsed : 0;
+}
+
+unsigned long HC12::GetUartByteTime() const
+{
+    // 10 bits per byte (start, 8 data and stop bit), rounded up.
+    unsigned long baud = (unsigned long)this->config.Baudrate();
+    return (10000000UL + baud - 1) / baud;
+}
+
+unsigned int HC12::UartBacklog()
+{
+    this->UpdateTransmitModel();
+    unsigned long byteTime = this->GetUartByteTime();
+    return (unsigned int)((this->uartBusy + byteTime - 1) / byteTime);
+}
+
+unsigned int HC12::ModuleBacklog()
+{
+    this->UpdateTransmitModel();
+    if (this->airBusy <= kModulePacketLatency)
     {
-        LOG("Received FU mode wasn't a supported value. Value was: " + String((int)power) + ".");
+        return 0;
     }
-    return power_success;
+    unsigned long airtime = this->GetByteAirtime();
+    return (unsigned int)((this->airBusy - kModulePacketLatency + airtime - 1) / airtime);
 }
 
-bool HC12::RequestOperationalMode()
+bool HC12::BeginCommandSession(CommandStep first, CommandStep last, const Deadline &deadline)
 {
-    String result = this->SendCommandAndGetResult("AT+RF");
-    if (result.startsWith("OK+FU") == false)
+    if (this->IsCommandBusy())
+    {
+        LOG("A command session is already running.");
+        return false;
+    }
+    if (deadline.Remaining() <= kCommandModeEnterTime + kCommandModeExitTime)
     {
-        LOG("FU value request reply didn't start AT+FU but was: " + result + ".");
+        LOG("Not enough time left to enter and leave command mode.");
         return false;
     }
-    result.remove(0, 5);
-    OperationalMode power = (OperationalMode)result.substring(0, 1).toInt();
-    bool power_success = IsOperationalMode(power);
-    if (power_success)
+    this->commandDeadline = deadline;
+    this->commandStep = first;
+    this->commandLastStep = last;
+    this->commandSuccess = true;
+    this->commandDirty = this->dirtyConfig;
+    this->commandReported = 0;
+    this->EnterCommandState(CommandState::Deferred);
+    if (this->IsTrafficIdle())
     {
-        this->operationalMode.ForceUpdateCurrent(power);
+        this->EnterCommandMode();
     }
-    else
+    return true;
+}
+
+void HC12::EnterCommandMode()
+{
+    this->commandSessionStart = millis();
+    this->WakeUp();
+    // Whatever is waiting now is user data, keep it before the command replies start.
+    this->SaveReceived();
+    digitalWrite(this->setPin, LOW);
+    this->EnterCommandState(CommandState::Entering);
+}
+
+bool HC12::IsTrafficIdle()
+{
+    return this->airFlush() && this->serial.available() == 0 &&
+           micros() - this->lastReceive >= this->FrameGap();
+}
+
+bool HC12::IsInCommandMode() const
+{
+    return this->commandState != CommandState::Idle && this->commandState != CommandState::Deferred;
+}
+
+bool HC12::WaitForCommandSession()
+{
+    while (this->IsCommandBusy())
     {
-        LOG("Received FU mode wasn't a valid mode. Value was: " + String((int)power) + ". Full response: " + result + ".");
+        this->poll();
+        yield();
     }
+    return this->commandSuccess;
+}
 
-    if (result.length() > 1)
+void HC12::PumpCommand()
+{
+    unsigned long elapsed = millis() - this->commandStateStart;
+    switch (this->commandState)
     {
-        Baudrates baud = (Baudrates)result.substring(3, result.length()).toInt();
-        bool baud_success = IsBaudrate(baud);
-        if (baud_success)
+    case CommandState::Idle:
+        break;
+    case CommandState::Deferred:
+        // Leave enough time for at least one command when the deadline is close.
+        if (this->IsTrafficIdle() || elapsed >= kMaxCommandDeferral ||
+            this->commandDeadline.Remaining() <= kCommandModeEnterTime + kMaxCommandResponseTime + kCommandModeExitTime)
         {
-            this->baudrate.ForceUpdateCurrent((int)baud);
+            this->EnterCommandMode();
         }
-        else
+        break;
+    case CommandState::Entering:
+        // The module keeps passing on data it received until it is in command mode.
+        this->SaveReceived();
+        if (elapsed >= kCommandModeEnterTime)
+        {
+            this->SendNextCommand();
+        }
+        break;
+    case CommandState::WaitingReply:
+        while (this->serial.available() > 0)
+        {
+            int data = this->serial.read();
+            if (data < 0 || data == '\r')
+            {
+                continue;
+            }
+            if (data == '\n')
+            {
+                if (this->commandReplyLength == 0)
+                {
+                    continue;
+                }
+                if (++this->commandReplyLines >= kCommandTable[(uint8_t)this->commandStep].lines)
+                {
+                    this->FinishCommand();
+                    return;
+                }
+            }
+            if (this->commandReplyLength < kMaxReplyLength)
+            {
+                this->commandReply[this->commandReplyLength++] = (char)data;
+            }
+        }
+        if (elapsed >= this->commandTimeout)
         {
-            LOG("Received baudrate in FU mode wasn't a known supported value. Value was: " + String((int)baud) + ". Full response: " + result + ".");
+            this->FinishCommand();
         }
-        power_success = power_success && baud_success;
+        break;
+    case CommandState::Exiting:
+        if (elapsed >= kCommandModeExitTime)
+        {
+            this->commandState = CommandState::Idle;
+            this->commandMillis += millis() - this->commandSessionStart;
+            this->commandDeadline = Deadline::Never();
+            if (this->commandLastStep == CommandStep::Sleep && this->commandSuccess)
+            {
+                this->sleeping = true;
+                this->sleepStart = millis();
+            }
+            this->FireCommandComplete(this->commandSuccess);
+        }
+        break;
     }
-    return power_success;
 }
 
-bool HC12::UpdateChannel()
+void HC12::SendNextCommand()
 {
-    String channelString = String(this->channel.New());
-    while (channelString.length() != 3)
+    while (this->commandStep <= this->commandLastStep && !this->IsCommandStepNeeded(this->commandStep))
     {
-        channelString = "0" + channelString;
+        this->commandStep = (CommandStep)((uint8_t)this->commandStep + 1);
     }
-    String result = this->SendCommandAndGetResult("AT+C" + channelString);
-    bool success = (result == ("OK+C" + channelString));
-    if (success)
+    if (this->commandStep > this->commandLastStep)
     {
-        this->channel.MarkUpdated();
+        this->LeaveCommandMode();
+        return;
     }
-    else
+    if (this->commandState == CommandState::Entering)
     {
-        LOG("Received channel wasn't the same as what was send. Response was: " + result + ".");
+        // Nothing can be a reply before the first command, later data would only be stale replies.
+        this->SaveReceived();
+        this->CloseOpenFrame();
     }
-    return success;
+    unsigned long timeout = CommandTimeout(this->commandDeadline);
+    if (timeout == 0)
+    {
+        LOG("Command session ran out of time.");
+        this->commandSuccess = false;
+        this->LeaveCommandMode();
+        return;
+    }
+    const CommandDescription &description = kCommandTable[(uint8_t)this->commandStep];
+    if (this->capabilities.responseMillis > 0)
+    {
+        // The firmware is known, so a reply that takes much longer than measured isn't coming anymore.
+        unsigned long expected = this->capabilities.responseMillis * 2UL * description.lines + kCommandResponseMargin;
+        timeout = (expected < timeout) ? expected : timeout;
+    }
+    char command[kMaxCommandLength + 1];
+    FormatCommand(description, this->pendingConfig, command);
+    SendCommand(this->serial, command);
+    this->commandTimeout = timeout;
+    this->commandReplyLength = 0;
+    this->commandReplyLines = 0;
+    this->EnterCommandState(CommandState::WaitingReply);
 }
 
-bool HC12::RequestChannel()
+void HC12::FinishCommand()
 {
-    String result = this->SendCommandAndGetResult("AT+RC");
-    if (result.startsWith("OK+RC") == false)
+    // Trim the line ending (and any other whitespace) around the reply.
+    char *reply = this->commandReply;
+    while (this->commandReplyLength > 0 && isspace((unsigned char)reply[this->commandReplyLength - 1]))
     {
-        LOG("Channel value request reply didn't start with AT+RC but was: " + result + ".");
-        return false;
+        this->commandReplyLength--;
     }
-    result.remove(0, 5);
-    int channel = result.toInt();
-    bool success = channel > 0 && channel < 127;
-    if (success)
+    reply[this->commandReplyLength] = '\0';
+    while (isspace((unsigned char)*reply))
     {
-        this->channel.ForceUpdateCurrent(channel);
+        reply++;
     }
-    else
+    if (!this->HandleCommandReply(this->commandStep, reply, millis() - this->commandStateStart))
     {
-        LOG("Received channel wasn't between 0 and 128 (non-inclusive). Response was: " + String(channel) + ".");
+        if (this->commandStep == CommandStep::RequestAll)
+        {
+            // Support for AT+RX is only assumed from the version, so ask for the parameters one by one instead.
+            LOG("AT+RX isn't supported, falling back to the separate requests.");
+            this->capabilities.requestAll = false;
+            this->commandStep = CommandStep::RequestChannel;
+            this->SendNextCommand();
+            return;
+        }
+        this->commandSuccess = false;
+    }
+    this->commandStep = (CommandStep)((uint8_t)this->commandStep + 1);
+    this->SendNextCommand();
+}
+
+void HC12::LeaveCommandMode()
+{
+    digitalWrite(this->setPin, HIGH);
+    this->EnterCommandState(CommandState::Exiting);
+}
+
+void HC12::EnterCommandState(CommandState state)
+{
+    this->commandState = state;
+    this->commandStateStart = millis();
+}
+
+bool HC12::IsCommandStepNeeded(CommandStep step) const
+{
+    // Based on what was dirty when the session started and what the replies so far reported. A field that was
+    // updated, or came along with another reply (like the baudrate in "OK+FU3,B9600"), isn't requested again.
+    const CommandDescription &description = kCommandTable[(uint8_t)step];
+    switch (description.effect)
+    {
+    case CommandEffect::Update:
+        return (this->commandDirty & ~this->commandReported & description.field) != 0;
+    case CommandEffect::Request:
+        if (step == CommandStep::RequestAll)
+        {
+            // One command for all parameters, after all updates are done.
+            return this->capabilities.requestAll;
+        }
+        return !this->capabilities.requestAll && ((this->commandDirty | this->commandReported) & description.field) == 0;
+    default:
+        return true;
     }
-    return success;
 }
 
-bool HC12::UpdateTransmitPower()
+// Rows are in the order of `CommandStep`.
+const HC12::CommandDescription HC12::kCommandTable[(uint8_t)CommandStep::RequestAll + 1] = {
+    {"AT", CommandArgument::None, "OK", ReplyValue::None, 1, CommandEffect::None, 0},
+    {"AT+V", CommandArgument::None, "", ReplyValue::Text, 1, CommandEffect::Version, 0},
+    {"AT+SLEEP", CommandArgument::None, "OK+SLEEP", ReplyValue::None, 1, CommandEffect::None, 0},
+    {"AT+DEFAULT", CommandArgument::None, "OK+DEFAULT", ReplyValue::None, 1, CommandEffect::Reset, Config::kAll},
+    {"AT+B", CommandArgument::Decimal, "OK+B", ReplyValue::Decimal, 1, CommandEffect::Update, Config::kBaudrate},
+    {"AT+C", CommandArgument::ThreeDigits, "OK+C", ReplyValue::Decimal, 1, CommandEffect::Update, Config::kChannel},
+    {"AT+RC", CommandArgument::None, "OK+RC", ReplyValue::Decimal, 1, CommandEffect::Request, Config::kChannel},
+    {"AT+P", CommandArgument::Decimal, "OK+P", ReplyValue::Decimal, 1, CommandEffect::Update, Config::kTransmitPower},
+    {"AT+RP", CommandArgument::None, "OK+RP:", ReplyValue::Dbm, 1, CommandEffect::Request, Config::kTransmitPower},
+    {"AT+FU", CommandArgument::Decimal, "OK+FU", ReplyValue::ModeAndBaudrate, 1, CommandEffect::Update, Config::kOperationalMode},
+    {"AT+RF", CommandArgument::None, "OK+FU", ReplyValue::ModeAndBaudrate, 1, CommandEffect::Request, Config::kOperationalMode},
+    {"AT+RB", CommandArgument::None, "OK+B", ReplyValue::Decimal, 1, CommandEffect::Request, Config::kBaudrate},
+    {"AT+RX", CommandArgument::None, "", ReplyValue::AllParameters, 4, CommandEffect::Request, Config::kAll},
+};
+
+bool HC12::HandleCommandReply(CommandStep step, const char *reply, unsigned long latency)
 {
-    const String kChannelString = String((int)this->transmitPower.New());
-    String result = this->SendCommandAndGetResult("AT+P" + kChannelString);
-    bool success = (result == ("OK+P" + kChannelString));
-    if (success)
+    const CommandDescription &command = kCommandTable[(uint8_t)step];
+    Config value = this->config;
+    uint8_t fields = 0;
+    if (!ParseReply(command, reply, value, fields))
     {
-        this->transmitPower.MarkUpdated();
+        if (command.effect == CommandEffect::Version)
+        {
+            // Not every firmware answers AT+V, that is no reason to fail the session.
+            LOG("No firmware version was reported, keeping the basic capabilities.");
+            return true;
+        }
+        LOG(String("Reply to ") + command.request + " wasn't valid. Response was: " + reply + ".");
+        return false;
     }
-    else
+    switch (command.effect)
     {
-        LOG("Received channel didn't match what was requested. Response was: " + result + ".");
+    case CommandEffect::None:
+        break;
+    case CommandEffect::Update:
+        if ((value.Diff(this->pendingConfig) & command.field) != 0)
+        {
+            LOG(String("Reply to ") + command.request + " didn't match what was send. Response was: " + reply + ".");
+            return false;
+        }
+        this->StoreConfig(value, fields);
+        break;
+    case CommandEffect::Request:
+        this->StoreConfig(value, fields);
+        break;
+    case CommandEffect::Reset:
+        this->AccountIdle();
+        this->config = Config(Baudrates::BPS_9600, OperationalMode::FU3, 1, TransmitPower::mW_100_0);
+        this->pendingConfig = this->config;
+        this->dirtyConfig = 0;
+        LOG("Reset was successful.");
+        break;
+    case CommandEffect::Version:
+        if (!ParseVersion(reply, this->capabilities))
+        {
+            LOG(String("Firmware version wasn't recognized, keeping the basic capabilities. Response was: ") + reply + ".");
+            return true;
+        }
+        this->capabilities.responseMillis = (latency < 255) ? (uint8_t)(latency + 1) : 255;
+        break;
     }
-    return success;
+    return true;
 }
 
-bool HC12::RequestTransmitPower()
+bool HC12::ParseVersion(const char *reply, Capabilities &capabilities)
 {
-    String result = this->SendCommandAndGetResult("AT+RP");
-    if (result.startsWith("OK+RP:") == false)
+    // Replies look like "www.hc01.com  HC-12_V2.4", only the version at the end is the same everywhere.
+    const char *version = reply;
+    while ((version = strchr(version, 'V')) != nullptr && !isdigit((unsigned char)version[1]))
     {
-        LOG("Transmission power value request reply didn't start with AT+RP. Response was: " + result + ".");
-        return false;
+        version++;
     }
-    if (result.endsWith("dBm") == false)
+    if (version == nullptr)
     {
-        LOG("Transmission power value request reply didn't end with dBm. Response was: " + result + ".");
         return false;
     }
-    result.remove(0, 6);
-    result.remove(result.length() - 3, 3);
-    TransmitPower power = TransmitPower::mW_0_8;
-    bool success = DbmToTransmitPower(result.toInt(), power);
-    if (success)
+    long major = 0;
+    long minor = 0;
+    const char *rest = ParseNumber(version + 1, major);
+    if (rest != nullptr && *rest == '.')
     {
-        this->transmitPower.ForceUpdateCurrent(power);
+        ParseNumber(rest + 1, minor);
     }
-    else
+    capabilities.versionMajor = (uint8_t)major;
+    capabilities.versionMinor = (uint8_t)minor;
+    // The V2 firmware documents AT+RX, which reports all parameters at once.
+    capabilities.requestAll = (major >= 2);
+    return true;
+}
+
+size_t HC12::FormatCommand(const CommandDescription &command, const Config &config, char *buffer)
+{
+    size_t length = strlen(command.request);
+    memcpy(buffer, command.request, length);
+    unsigned long value = ConfigValue(config, command.field);
+    switch (command.argument)
+    {
+    case CommandArgument::None:
+        break;
+    case CommandArgument::Decimal:
     {
-        LOG("Received dBm value wasn't a valid TransmitPower value. Value was: " + result + ".");
+        char digits[10];
+        uint8_t count = 0;
+        do
+        {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        while (count > 0)
+        {
+            buffer[length++] = digits[--count];
+        }
+        break;
+    }
+    case CommandArgument::ThreeDigits:
+        buffer[length++] = '0' + value / 100 % 10;
+        buffer[length++] = '0' + value / 10 % 10;
+        buffer[length++] = '0' + value % 10;
+        break;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+bool HC12::ParseReply(const CommandDescription &command, const char *reply, Config &value, uint8_t &fields)
+{
+    fields = 0;
+    size_t prefixLength = strlen(command.reply);
+    if (strncmp(reply, command.reply, prefixLength) != 0)
+    {
+        return false;
+    }
+    const char *rest = reply + prefixLength;
+    long number = 0;
+    switch (command.value)
+    {
+    case ReplyValue::None:
+        return *rest == '\0';
+    case ReplyValue::Text:
+        return *rest != '\0';
+    case ReplyValue::AllParameters:
+    {
+        // One line per parameter, each in the same format as the reply to its own request.
+        static const CommandStep kLineSteps[] = {CommandStep::RequestBaudrate, CommandStep::RequestChannel,
+                                                 CommandStep::RequestTransmitPower, CommandStep::RequestOperationalMode};
+        while (*rest != '\0')
+        {
+            const char *end = strchr(rest, '\n');
+            size_t length = (end != nullptr) ? (size_t)(end - rest) : strlen(rest);
+            char line[kMaxReplyLength + 1];
+            memcpy(line, rest, length);
+            line[length] = '\0';
+            uint8_t lineFields = 0;
+            for (CommandStep step : kLineSteps)
+            {
+                if (ParseReply(kCommandTable[(uint8_t)step], line, value, lineFields))
+                {
+                    fields |= lineFields;
+                    break;
+                }
+            }
+            rest += (end != nullptr) ? length + 1 : length;
+        }
+        return fields == Config::kAll;
+    }
+    case ReplyValue::Decimal:
+        rest = ParseNumber(rest, number);
+        break;
+    case ReplyValue::Dbm:
+    {
+        TransmitPower power = TransmitPower::mW_0_8;
+        rest = ParseNumber(rest, number);
+        if (rest == nullptr || strcmp(rest, "dBm") != 0 || !DbmToTransmitPower((int)number, power))
+        {
+            return false;
+        }
+        number = (long)power;
+        rest += 3;
+        break;
+    }
+    case ReplyValue::ModeAndBaudrate:
+        // Some firmware adds the baudrate the mode ended up with, like "OK+FU3,B9600".
+        rest = ParseNumber(rest, number);
+        if (rest != nullptr && strncmp(rest, ",B", 2) == 0)
+        {
+            long baud = 0;
+            rest = ParseNumber(rest + 2, baud);
+            if (rest == nullptr || !SetConfigValue(value, Config::kBaudrate, baud))
+            {
+                return false;
+            }
+            fields |= Config::kBaudrate;
+        }
+        break;
+    }
+    if (rest == nullptr || *rest != '\0' || !SetConfigValue(value, command.field, number))
+    {
+        return false;
+    }
+    fields |= command.field;
+    return true;
+}
+
+const char *HC12::ParseNumber(const char *text, long &number)
+{
+    bool negative = (*text == '-');
+    if (*text == '-' || *text == '+')
+    {
+        text++;
+    }
+    if (!isdigit((unsigned char)*text))
+    {
+        return nullptr;
+    }
+    number = 0;
+    while (isdigit((unsigned char)*text))
+    {
+        number = number * 10 + (*text++ - '0');
+    }
+    if (negative)
+    {
+        number = -number;
+    }
+    return text;
+}
+
+bool HC12::SetConfigValue(Config &config, uint8_t field, long number)
+{
+    switch (field)
+    {
+    case Config::kBaudrate:
+        if (!IsBaudrate((Baudrates)number))
+        {
+            return false;
+        }
+        config.SetBaudrate((Baudrates)number);
+        return true;
+    case Config::kOperationalMode:
+        if (!IsOperationalMode((OperationalMode)number))
+        {
+            return false;
+        }
+        config.SetOperationalMode((OperationalMode)number);
+        return true;
+    case Config::kChannel:
+        if (!IsChannel((int)number))
+        {
+            return false;
+        }
+        config.SetChannel((unsigned int)number);
+        return true;
+    case Config::kTransmitPower:
+        if (!IsTransmitPower((TransmitPower)number))
+        {
+            return false;
+        }
+        config.SetTransmitPower((TransmitPower)number);
+        return true;
+    }
+    return false;
+}
+
+unsigned long HC12::ConfigValue(const Config &config, uint8_t field)
+{
+    switch (field)
+    {
+    case Config::kBaudrate:
+        return (unsigned long)config.Baudrate();
+    case Config::kOperationalMode:
+        return (unsigned long)config.Mode();
+    case Config::kChannel:
+        return config.Channel();
+    case Config::kTransmitPower:
+        return (unsigned long)config.Power();
+    }
+    return 0;
+}
+
+void HC12::StoreConfig(const Config &value, uint8_t fields)
+{
+    // What the module reported is the current value, and also the new one unless another one was prepared.
+    if ((fields & Config::kOperationalMode) != 0 && value.Mode() != this->config.Mode())
+    {
+        this->AccountIdle();
+    }
+    this->config.Copy(value, fields);
+    this->pendingConfig.Copy(value, fields & ~this->dirtyConfig);
+    this->dirtyConfig = this->config.Diff(this->pendingConfig);
+    this->commandReported |= fields;
+}
+
+bool HC12::ReadPacket(FrameView &frame, Deadline deadline)
+{
+    while (true)
+    {
+        this->poll();
+        if (this->PeekFrame(frame))
+        {
+            return true;
+        }
+        if (deadline.Expired())
+        {
+            return false;
+        }
+        yield();
+    }
+}
+
+unsigned long HC12::GetSavedBytes() const
+{
+    return this->savedBytes;
+}
+
+void HC12::WakeUp()
+{
+    // The module leaves sleep mode as soon as it enters command mode again.
+    if (this->sleeping)
+    {
+        this->sleepMillis += millis() - this->sleepStart;
+        this->sleeping = false;
+    }
+}
+
+void HC12::AccountTransmit(size_t size)
+{
+    unsigned long airtime = this->GetByteAirtime() * size;
+    this->transmitTime.Add(airtime);
+    this->transmitCharge += (float)this->energyProfile.transmitMicroamp[(int)this->config.Power() - 1] * airtime / 1000.0f;
+    this->bytesTransmitted += size;
+
+    // The UART sends the bytes after whatever it still had to send. The air can only send a byte once it reached the
+    // module, so it ends at least one byte airtime after the UART.
+    this->UpdateTransmitModel();
+    this->uartBusy += this->GetUartByteTime() * size;
+    unsigned long air = (this->airBusy > kModulePacketLatency) ? this->airBusy - kModulePacketLatency : 0;
+    air += airtime;
+    if (air < this->uartBusy + this->GetByteAirtime())
+    {
+        air = this->uartBusy + this->GetByteAirtime();
+    }
+    this->airBusy = air + kModulePacketLatency;
+}
+
+unsigned long HC12::IdleMillis(unsigned long now) const
+{
+    unsigned long sleep = this->sleepMillis + (this->sleeping ? now - this->sleepStart : 0);
+    unsigned long elapsed = now - this->energyStart;
+    unsigned long accounted = this->transmitTime.millis + this->receiveTime.millis + this->commandMillis + sleep;
+    if (this->IsInCommandMode())
+    {
+        // The running session is only added to `commandMillis` when it ends.
+        accounted += now - this->commandSessionStart;
+    }
+    return (elapsed > accounted) ? elapsed - accounted : 0;
+}
+
+void HC12::AccountIdle()
+{
+    // Called before the mode changes, so the idle time up to now is priced at the mode it was spent in.
+    unsigned long idle = this->IdleMillis(millis());
+    if (idle > this->idleAccounted)
+    {
+        this->idleCharge += (float)this->energyProfile.idleMicroamp[(int)this->config.Mode() - 1] * (idle - this->idleAccounted);
+        this->idleAccounted = idle;
+    }
+}
+
+void HC12::AccountReceive(size_t size)
+{
+    this->receiveTime.Add(this->GetByteAirtime() * size);
+    this->bytesReceived += size;
+}
+
+bool HC12::onByte(ByteHandler handler, void *context)
+{
+    EventHandler *entry = this->AddHandler(EventType::Byte, context);
+    if (entry != nullptr)
+    {
+        entry->function.onByte = handler;
+    }
+    return entry != nullptr;
+}
+
+bool HC12::onPacket(PacketHandler handler, void *context)
+{
+    EventHandler *entry = this->AddHandler(EventType::Packet, context);
+    if (entry != nullptr)
+    {
+        entry->function.onPacket = handler;
+    }
+    return entry != nullptr;
+}
+
+bool HC12::onCommandComplete(CommandCompleteHandler handler, void *context)
+{
+    EventHandler *entry = this->AddHandler(EventType::CommandComplete, context);
+    if (entry != nullptr)
+    {
+        entry->function.onCommandComplete = handler;
+    }
+    return entry != nullptr;
+}
+
+bool HC12::RemoveHandler(ByteHandler handler, void *context)
+{
+    for (EventHandler &entry : this->handlers)
+    {
+        if (entry.type == EventType::Byte && entry.function.onByte == handler && entry.context == context)
+        {
+            entry.type = EventType::None;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HC12::RemoveHandler(PacketHandler handler, void *context)
+{
+    for (EventHandler &entry : this->handlers)
+    {
+        if (entry.type == EventType::Packet && entry.function.onPacket == handler && entry.context == context)
+        {
+            entry.type = EventType::None;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HC12::RemoveHandler(CommandCompleteHandler handler, void *context)
+{
+    for (EventHandler &entry : this->handlers)
+    {
+        if (entry.type == EventType::CommandComplete && entry.function.onCommandComplete == handler && entry.context == context)
+        {
+            entry.type = EventType::None;
+            return true;
+        }
+    }
+    return false;
+}
+
+HC12::EventHandler *HC12::AddHandler(EventType type, void *context)
+{
+    for (EventHandler &entry : this->handlers)
+    {
+        if (entry.type == EventType::None)
+        {
+            entry.type = type;
+            entry.context = context;
+            entry.sequence = ++this->handlerSequence;
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void HC12::DispatchPackets()
+{
+    FrameView frame;
+    while (this->HasHandler(EventType::Packet) && this->PeekFrame(frame))
+    {
+        unsigned long dispatch = this->handlerSequence;
+        for (const EventHandler &entry : this->handlers)
+        {
+            if (this->IsHandlerActive(entry, EventType::Packet, dispatch))
+            {
+                entry.function.onPacket(frame, entry.context);
+            }
+        }
+        this->ReleaseFrame();
+    }
+}
+
+bool HC12::FireCommandComplete(bool success)
+{
+    unsigned long dispatch = this->handlerSequence;
+    for (const EventHandler &entry : this->handlers)
+    {
+        if (this->IsHandlerActive(entry, EventType::CommandComplete, dispatch))
+        {
+            entry.function.onCommandComplete(success, entry.context);
+        }
     }
     return success;
 }
 
+bool HC12::HasHandler(EventType type) const
+{
+    for (const EventHandler &entry : this->handlers)
+    {
+        if (entry.type == type)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HC12::IsHandlerActive(const EventHandler &entry, EventType type, unsigned long dispatch) const
+{
+    // Handlers may (un)register handlers while being called. One that is added during a dispatch (even in the slot of
+    // one that was just removed) is newer than the dispatch, so it only sees the next event.
+    return entry.type == type && (long)(dispatch - entry.sequence) >= 0;
+}
+
+int HC12::available()
+{
+    if (this->IsInCommandMode())
+    {
+        return this->receiveCount;
+    }
+    return this->receiveCount + this->serial.available();
+}
+
+int HC12::read()
+{
+    if (this->receiveCount > 0)
+    {
+        uint8_t data = this->receiveBuffer[this->receiveHead];
+        this->ConsumeReceived(1);
+        return data;
+    }
+    if (this->IsInCommandMode())
+    {
+        return -1;
+    }
+    int data = this->serial.read();
+    if (data >= 0)
+    {
+        this->AccountReceive(1);
+    }
+    return data;
+}
+
+int HC12::peek()
+{
+    if (this->receiveCount > 0)
+    {
+        return this->receiveBuffer[this->receiveHead];
+    }
+    if (this->IsInCommandMode())
+    {
+        return -1;
+    }
+    return this->serial.peek();
+}
+
+size_t HC12::write(uint8_t data)
+{
+    if (this->IsInCommandMode())
+    {
+        return 0;
+    }
+    size_t written = this->serial.write(data);
+    this->AccountTransmit(written);
+    return written;
+}
+
+size_t HC12::write(const uint8_t *buffer, size_t size)
+{
+    if (this->IsInCommandMode())
+    {
+        return 0;
+    }
+    size_t written = this->serial.write(buffer, size);
+    this->AccountTransmit(written);
+    return written;
+}
+
+void HC12::flush()
+{
+    this->serial.flush();
+}
+
+int HC12::availableForWrite()
+{
+    if (this->IsInCommandMode())
+    {
+        // `write` doesn't send anything in command mode.
+        return 0;
+    }
+    unsigned int backlog = this->ModuleBacklog();
+    return (backlog < kModuleBufferSize) ? (int)(kModuleBufferSize - backlog) : 0;
+}
+
+bool HC12::airFlush()
+{
+    if (!this->IsTransmitQueueEmpty())
+    {
+        return false;
+    }
+    this->UpdateTransmitModel();
+    return this->airBusy == 0;
+}
+
+bool HC12::airFlush(Deadline deadline)
+{
+    while (true)
+    {
+        this->poll();
+        if (this->airFlush())
+        {
+            return true;
+        }
+        if (deadline.Expired())
+        {
+            return false;
+        }
+        yield();
+    }
+}
+
+size_t HC12::readBytes(char *buffer, size_t length)
+{
+    return this->readBytes((uint8_t *)buffer, length, Deadline::In(this->getTimeout()));
+}
+
+size_t HC12::readBytes(uint8_t *buffer, size_t length, Deadline deadline)
+{
+    size_t copied = this->CopyReceived(buffer, length);
+    this->ConsumeReceived(copied);
+    if (copied == length || this->IsInCommandMode())
+    {
+        return copied;
+    }
+
+    bool terminated = false;
+    size_t read = ReadSerial(this->serial, buffer + copied, length - copied, deadline, -1, terminated);
+    this->AccountReceive(read);
+    return copied + read;
+}
+
+size_t HC12::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+    return this->readBytesUntil(terminator, (uint8_t *)buffer, length, Deadline::In(this->getTimeout()));
+}
+
+size_t HC12::readBytesUntil(char terminator, uint8_t *buffer, size_t length, Deadline deadline)
+{
+    size_t copied = this->CopyReceived(buffer, length);
+    const void *found = memchr(buffer, terminator, copied);
+    if (found != nullptr)
+    {
+        size_t index = (const uint8_t *)found - buffer;
+        this->ConsumeReceived(index + 1);
+        return index;
+    }
+    this->ConsumeReceived(copied);
+    if (copied == length || this->IsInCommandMode())
+    {
+        return copied;
+    }
+
+    bool terminated = false;
+    size_t read = ReadSerial(this->serial, buffer + copied, length - copied, deadline, (uint8_t)terminator, terminated);
+    this->AccountReceive(read + (terminated ? 1 : 0));
+    return copied + read;
+}
+
+size_t HC12::ReadSerial(Stream &serial, uint8_t *buffer, size_t length, const Deadline &deadline, int terminator, bool &terminated)
+{
+    // Only what is already waiting is read at once, so the Stream timeout (which restarts for every byte) never comes
+    // into play and the deadline is the only thing that is waited for.
+    size_t read = 0;
+    terminated = false;
+    while (read < length)
+    {
+        int available = serial.available();
+        if (available <= 0)
+        {
+            if (deadline.Expired())
+            {
+                break;
+            }
+            yield();
+            continue;
+        }
+        size_t chunk = ((size_t)available < length - read) ? (size_t)available : length - read;
+        if (terminator < 0)
+        {
+            read += serial.readBytes(buffer + read, chunk);
+            continue;
+        }
+        size_t part = serial.readBytesUntil((char)terminator, buffer + read, chunk);
+        read += part;
+        if (part < chunk)
+        {
+            // Stopped early, so the terminator was found (and removed).
+            terminated = true;
+            break;
+        }
+    }
+    return read;
+}
+
+size_t HC12::peek(uint8_t *buffer, size_t length)
+{
+    if (!this->IsInCommandMode())
+    {
+        // Only move the data, looking ahead must not close frames or call the packet handlers.
+        this->ReceiveAvailable();
+    }
+    return this->CopyReceived(buffer, length);
+}
+
+size_t HC12::CopyReceived(uint8_t *buffer, size_t size) const
+{
+    if (size > this->receiveCount)
+    {
+        size = this->receiveCount;
+    }
+    size_t contiguous = HC12_RX_BUFFER_SIZE - this->receiveHead;
+    size_t first = (size < contiguous) ? size : contiguous;
+    memcpy(buffer, &this->receiveBuffer[this->receiveHead], first);
+    memcpy(buffer + first, this->receiveBuffer, size - first);
+    return size;
+}
+
+bool HC12::SendCommandAndGetOK(Stream &serial, const String &command, unsigned long timeout)
+{
+    String response = SendCommandAndGetResult(serial, command, timeout);
+    return response == "OK";
+}
+
+String HC12::SendCommandAndGetResult(Stream &serial, const String &command, unsigned long timeout)
+{
+    SendCommand(serial, command.c_str());
+    // The timeout bounds the whole reply, `readStringUntil` would restart it for every byte.
+    char reply[kMaxReplyLength + 1];
+    bool terminated = false;
+    size_t length = ReadSerial(serial, (uint8_t *)reply, kMaxReplyLength, Deadline::In(timeout), '\n', terminated);
+    reply[length] = '\0';
+    String response(reply);
+    response.trim();
+    return response;
+}
+
+void HC12::SendCommand(Stream &serial, const char *command)
+{
+    // Drop old data since in command mode this can't be valid userdata anymore, the sessions of an instance have
+    // already moved the user data into the receive ring buffer.
+    while (serial.available())
+    {
+        serial.read();
+    }
+    serial.write(command);
+    serial.write('\r');
+    serial.write('\n');
+}
+
 bool HC12::DbmToTransmitPower(int dbm, TransmitPower &power)
 {
     bool success = true;
@@ -7,7 +7,23 @@
  * @version 0.3 2022-06-12 Refactor the code to keep track of changes into small helper class.
  * @version 0.4 2022-06-13 Added size_t write(*buffer, size) override to support writing whole buffers at once.
  * @version 0.5 2022-06-14 Added flush override.
- * @date 2022-06-14
+ * @version 0.6 2026-10-17 Added airtime model and energy accounting per module state.
+ * @version 0.7 2026-10-17 Added priority transmit queues drained by a pacer in `poll()`, with `kMaxFrameSize` as the size limit of a queued frame.
+ * @version 0.8 2026-10-17 Added receive ring buffer with zero copy frame views.
+ * @version 0.9 2026-10-17 Added scatter gather `writev` and `Enqueue` with an optional CRC-16.
+ * @version 0.10 2026-10-17 Added bulk `readBytes`, `readBytesUntil` and multi byte `peek` overrides, `peek` only moves data into the receive ring.
+ * @version 0.11 2026-10-17 Added `availableForWrite` override based on the model of the module buffer.
+ * @version 0.12 2026-10-17 Added `onByte`, `onPacket` and `onCommandComplete` callbacks in a fixed size table.
+ * @version 0.13 2026-10-17 Added `Deadline` that bounds every blocking call, reads are bounded as a whole.
+ * @version 0.14 2026-10-17 Command mode operations run as a non-blocking state machine driven by `poll()`.
+ * @version 0.15 2026-10-17 Added coroutine versions of the command mode operations and packet reads (see HC12Async.h).
+ * @version 0.16 2026-10-17 Data received while entering command mode is kept in the receive ring instead of dropped.
+ * @version 0.17 2026-10-17 Command mode sessions wait for a gap in the traffic before the SET pin goes low.
+ * @version 0.18 2026-10-17 Added `airFlush` that models when the module has sent everything over the air, after the UART drain.
+ * @version 0.19 2026-10-17 The parameters are kept in a packed `Config` word with a dirty mask instead of four `Updatable`s, every parameter is validated and the `Prepare*` functions report invalid values.
+ * @version 0.20 2026-10-17 AT commands and their replies are described in one table instead of a handler per command.
+ * @version 0.21 2026-10-17 `begin` can detect the firmware version (`AT+V`) and use `AT+RX` and measured reply times, with the basic capabilities as fallback.
+ * @date 2026-10-17
  *
  * @copyright Copyright (c) 2022
  *
@@ -17,6 +33,73 @@
 #define INCLUDE_ARDUINO_HC12_H
 
 #include "Arduino.h"
+#include "HC12Crc16.h"
+
+/**
+ * @brief Number of transmit priorities, each has its own statically allocated queue. Priority 0 is the highest.
+ * 
+ */
+#ifndef HC12_TX_PRIORITIES
+#define HC12_TX_PRIORITIES 2
+#endif
+
+/**
+ * @brief Size in bytes of the queue for each transmit priority (every queued frame uses one extra byte).
+ * 
+ */
+#ifndef HC12_TX_QUEUE_SIZE
+#define HC12_TX_QUEUE_SIZE 64
+#endif
+
+/**
+ * @brief Size in bytes of the receive ring buffer that `poll()` fills.
+ * 
+ */
+#ifndef HC12_RX_BUFFER_SIZE
+#define HC12_RX_BUFFER_SIZE 128
+#endif
+
+/**
+ * @brief Maximum amount of complete frames that can be waiting in the receive ring buffer.
+ * 
+ */
+#ifndef HC12_RX_MAX_FRAMES
+#define HC12_RX_MAX_FRAMES 8
+#endif
+
+/**
+ * @brief Maximum amount of event handlers (of all types together) that can be registered.
+ * 
+ */
+#ifndef HC12_MAX_HANDLERS
+#define HC12_MAX_HANDLERS 4
+#endif
+
+/**
+ * @brief Ties a build to the sizes above, which change the layout of `HC12`.
+ * @details The sizes must be the same for the sketch and the library, so set them as global build flags (like
+ * PlatformIO `build_flags`). A `#define` in the sketch never reaches HC12.cpp in an Arduino build. HC12.cpp only
+ * defines `kCheck` for the sizes it was compiled with and every constructor call refers to the one of the sizes the
+ * caller sees, so a mismatch fails to link (undefined reference to `HC12Layout<...>::kCheck`) instead of corrupting
+ * memory.
+ * 
+ */
+template <unsigned long kTxPriorities, unsigned long kTxQueueSize, unsigned long kRxBufferSize, unsigned long kRxMaxFrames,
+          unsigned long kMaxHandlers>
+struct HC12Layout
+{
+    static const uint8_t kCheck;
+};
+typedef HC12Layout<HC12_TX_PRIORITIES, HC12_TX_QUEUE_SIZE, HC12_RX_BUFFER_SIZE, HC12_RX_MAX_FRAMES, HC12_MAX_HANDLERS> HC12BuildLayout;
+template <>
+const uint8_t HC12BuildLayout::kCheck;
+
+// The awaitable types are in HC12Async.h, which has to be included to use the `*Async` functions.
+#ifdef __cpp_impl_coroutine
+#define HC12_HAS_COROUTINES 1
+class HC12CommandAwaiter;
+class HC12PacketAwaiter;
+#endif
 
 /**
  * @brief Class that helps with communicating with the HC12 module.
@@ -31,6 +114,80 @@ public:
      */
     static constexpr unsigned long kMaxCommandResponseTime = 150UL;
 
+    /**
+     * @brief Time in milli seconds the module needs after the SET pin went low before it accepts commands.
+     * 
+     */
+    static constexpr unsigned long kCommandModeEnterTime = 40UL;
+
+    /**
+     * @brief Time in milli seconds the module needs after the SET pin went high before it is back in its normal mode.
+     * 
+     */
+    static constexpr unsigned long kCommandModeExitTime = 80UL;
+
+    /**
+     * @brief Maximum time in milli seconds a command mode session waits for a gap in the traffic before it starts anyway.
+     * 
+     */
+    static constexpr unsigned long kMaxCommandDeferral = 1000UL;
+
+    /**
+     * @brief Estimate of the amount of bytes the module can buffer before it has send them over the air.
+     * 
+     */
+    static constexpr unsigned int kModuleBufferSize = 64;
+
+    /**
+     * @brief Time in micro seconds the module needs after the last byte of a packet before it is on air (rough figure).
+     * 
+     */
+    static constexpr unsigned long kModulePacketLatency = 4000UL;
+
+    /**
+     * @brief The amount of bytes `poll()` keeps in the module (about one short frame), so a higher priority frame that
+     * is queued later only has to wait for that, not for a full module buffer.
+     * 
+     */
+    static constexpr unsigned int kTransmitLowWatermark = 16;
+
+    /**
+     * @brief Estimate of the amount of bytes the serial can buffer before `write` blocks (the TX buffer on AVR, the
+     * hardware FIFO on the ESP32 is bigger).
+     * 
+     */
+    static constexpr unsigned int kSerialBufferSize = 64;
+
+    /**
+     * @brief The highest priority that can be given to `Enqueue`.
+     * 
+     */
+    static constexpr uint8_t kHighestPriority = 0;
+
+    /**
+     * @brief The lowest priority that can be given to `Enqueue`.
+     * 
+     */
+    static constexpr uint8_t kLowestPriority = HC12_TX_PRIORITIES - 1;
+
+    /**
+     * @brief The biggest frame that can be given to `Enqueue`: a queue also stores the length byte, and at most 255.
+     * 
+     */
+    static constexpr size_t kMaxFrameSize = (HC12_TX_QUEUE_SIZE - 1 < 255) ? HC12_TX_QUEUE_SIZE - 1 : 255;
+
+    /**
+     * @brief The amount of byte times (at the serial baudrate) without data that ends a received frame.
+     * 
+     */
+    static constexpr unsigned long kFrameGapBytes = 4UL;
+
+    /**
+     * @brief Minimum time in micro seconds without data that ends a received frame.
+     * 
+     */
+    static constexpr unsigned long kMinFrameGap = 2000UL;
+
     /**
      * @brief The different FU power modes the module can be in.
      * 
@@ -68,129 +225,746 @@ public:
     };
 
     /**
-     * @brief The supported baudrates by the HC-12 module.
+     * @brief The supported baudrates by the HC-12 module.
+     * 
+     */
+    enum class Baudrates
+    {
+        BPS_1200 = 1200,
+        BPS_2400 = 2400,
+        BPS_4800 = 4800,
+        BPS_9600 = 9600,
+        BPS_19200 = 19200,
+        BPS_138400 = 138400,
+        BPS_57600 = 57600,
+        BPS_115200 = 115200
+    };
+
+    /**
+     * @brief All the parameters of the module packed into a single word, so they are cheap to compare, store and send.
+     * @details The word holds the channel (bits 0-7), transmit power (8-11), operational mode (12-14) and the index of
+     * the baudrate (16-18). The field masks are used to tell which parameters differ between two configs.
+     * 
+     */
+    class Config
+    {
+    public:
+        static constexpr uint8_t kBaudrate = 0x01;
+        static constexpr uint8_t kOperationalMode = 0x02;
+        static constexpr uint8_t kChannel = 0x04;
+        static constexpr uint8_t kTransmitPower = 0x08;
+        static constexpr uint8_t kAll = kBaudrate | kOperationalMode | kChannel | kTransmitPower;
+
+    private:
+        static constexpr uint32_t kChannelBits = 0x000000FFUL;
+        static constexpr uint32_t kTransmitPowerBits = 0x00000F00UL;
+        static constexpr uint32_t kOperationalModeBits = 0x00007000UL;
+        static constexpr uint32_t kBaudrateBits = 0x00070000UL;
+
+        uint32_t word;
+
+    public:
+        Config(Baudrates baudrate, OperationalMode mode, unsigned int channel, TransmitPower power) : word(0)
+        {
+            this->SetBaudrate(baudrate);
+            this->SetOperationalMode(mode);
+            this->SetChannel(channel);
+            this->SetTransmitPower(power);
+        }
+
+        /**
+         * @brief Create a config from a word that was taken from `Word()`, for example after storing or receiving it.
+         * @details The word is taken as is, check it with `IsValid()` (`PrepareConfig` refuses an invalid config).
+         * 
+         * @param word The packed config.
+         * @return Config The config.
+         */
+        static Config FromWord(uint32_t word)
+        {
+            Config config(Baudrates::BPS_9600, OperationalMode::FU3, 1, TransmitPower::mW_100_0);
+            config.word = word;
+            return config;
+        }
+
+        /**
+         * @brief Get the packed config.
+         * 
+         * @return uint32_t The word with all the parameters.
+         */
+        uint32_t Word() const
+        {
+            return this->word;
+        }
+
+        /**
+         * @brief Check if every parameter in the word is one the module supports.
+         * 
+         * @return true If all parameters are valid.
+         * @return false If the mode, channel or transmit power is out of range.
+         */
+        bool IsValid() const
+        {
+            return IsOperationalMode(this->Mode()) && IsChannel((int)this->Channel()) && IsTransmitPower(this->Power());
+        }
+
+        Baudrates Baudrate() const
+        {
+            static const Baudrates kBaudrates[] = {Baudrates::BPS_1200, Baudrates::BPS_2400, Baudrates::BPS_4800,
+                                                   Baudrates::BPS_9600, Baudrates::BPS_19200, Baudrates::BPS_138400,
+                                                   Baudrates::BPS_57600, Baudrates::BPS_115200};
+            return kBaudrates[(this->word & kBaudrateBits) >> 16];
+        }
+
+        OperationalMode Mode() const
+        {
+            return (OperationalMode)((this->word & kOperationalModeBits) >> 12);
+        }
+
+        unsigned int Channel() const
+        {
+            return this->word & kChannelBits;
+        }
+
+        TransmitPower Power() const
+        {
+            return (TransmitPower)((this->word & kTransmitPowerBits) >> 8);
+        }
+
+        void SetBaudrate(Baudrates baudrate)
+        {
+            uint32_t index = 3; // 9600 for anything unknown.
+            switch (baudrate)
+            {
+            case Baudrates::BPS_1200: index = 0; break;
+            case Baudrates::BPS_2400: index = 1; break;
+            case Baudrates::BPS_4800: index = 2; break;
+            case Baudrates::BPS_9600: index = 3; break;
+            case Baudrates::BPS_19200: index = 4; break;
+            case Baudrates::BPS_138400: index = 5; break;
+            case Baudrates::BPS_57600: index = 6; break;
+            case Baudrates::BPS_115200: index = 7; break;
+            }
+            this->word = (this->word & ~kBaudrateBits) | (index << 16);
+        }
+
+        void SetOperationalMode(OperationalMode mode)
+        {
+            uint32_t value = IsOperationalMode(mode) ? (uint32_t)mode : (uint32_t)OperationalMode::FU3; // FU3 for anything unknown.
+            this->word = (this->word & ~kOperationalModeBits) | (value << 12);
+        }
+
+        void SetChannel(unsigned int channel)
+        {
+            uint32_t value = IsChannel((int)channel) ? channel : 1; // Channel 1 for anything unknown.
+            this->word = (this->word & ~kChannelBits) | value;
+        }
+
+        void SetTransmitPower(TransmitPower power)
+        {
+            uint32_t value = IsTransmitPower(power) ? (uint32_t)power : (uint32_t)TransmitPower::mW_100_0; // 100 mW for anything unknown.
+            this->word = (this->word & ~kTransmitPowerBits) | (value << 8);
+        }
+
+        /**
+         * @brief Get the parameters that differ from another config.
+         * 
+         * @param other The config to compare with.
+         * @return uint8_t The field masks (`kBaudrate`, `kChannel`, ...) of the parameters that differ.
+         */
+        uint8_t Diff(const Config &other) const
+        {
+            uint32_t changed = this->word ^ other.word;
+            return ((changed & kBaudrateBits) ? kBaudrate : 0) | ((changed & kOperationalModeBits) ? kOperationalMode : 0) |
+                   ((changed & kChannelBits) ? kChannel : 0) | ((changed & kTransmitPowerBits) ? kTransmitPower : 0);
+        }
+
+        /**
+         * @brief Take some of the parameters from another config.
+         * 
+         * @param other The config to copy from.
+         * @param fields The field masks of the parameters to copy.
+         */
+        void Copy(const Config &other, uint8_t fields)
+        {
+            uint32_t bits = ((fields & kBaudrate) ? kBaudrateBits : 0) | ((fields & kOperationalMode) ? kOperationalModeBits : 0) |
+                            ((fields & kChannel) ? kChannelBits : 0) | ((fields & kTransmitPower) ? kTransmitPowerBits : 0);
+            this->word = (this->word & ~bits) | (other.word & bits);
+        }
+    };
+
+    /**
+     * @brief What the firmware of the module supports, detected with `AT+V` by `begin(deadline, true)`.
+     * @details Store it next to the `Config` word and give it back with `SetCapabilities` to skip the detection on the
+     * next start. Without it the driver uses the behaviour every firmware supports.
+     * 
+     */
+    struct Capabilities
+    {
+        uint8_t versionMajor;
+        uint8_t versionMinor;
+        bool requestAll; // Cleared again when an `AT+RX` reply can't be parsed.
+        uint8_t responseMillis;
+    };
+
+    /**
+     * @brief The current draw of the module in each of its states, used to estimate the energy usage.
+     * @details All currents are in micro ampere. The defaults are rough figures from the datasheet.
+     * 
+     */
+    struct EnergyProfile
+    {
+        /**
+         * @brief The supply voltage of the module in milli volt.
+         * 
+         */
+        unsigned int supplyMillivolt = 3300;
+
+        /**
+         * @brief Current while transmitting, indexed by `TransmitPower` - 1.
+         * 
+         */
+        unsigned long transmitMicroamp[8] = {16000UL, 18000UL, 21000UL, 25000UL, 32000UL, 43000UL, 63000UL, 100000UL};
+
+        /**
+         * @brief Current while receiving a packet.
+         * 
+         */
+        unsigned long receiveMicroamp = 16000UL;
+
+        /**
+         * @brief Current while idle (listening), indexed by `OperationalMode` - 1.
+         * 
+         */
+        unsigned long idleMicroamp[4] = {3600UL, 80UL, 16000UL, 16000UL};
+
+        /**
+         * @brief Current while in sleep mode.
+         * 
+         */
+        unsigned long sleepMicroamp = 22UL;
+
+        /**
+         * @brief Current while in command mode.
+         * 
+         */
+        unsigned long commandMicroamp = 16000UL;
+    };
+
+    /**
+     * @brief Time spent in each state since `begin()` (or `ResetEnergyStats()`) and the estimated energy used.
+     * 
+     */
+    struct EnergyStats
+    {
+        unsigned long transmitMillis;
+        unsigned long receiveMillis;
+        unsigned long idleMillis;
+        unsigned long sleepMillis;
+        unsigned long commandMillis;
+        unsigned long bytesTransmitted;
+        unsigned long bytesReceived;
+        float energyMillijoule;
+    };
+
+    /**
+     * @brief A monotonic point in time (based on `millis()`) that a blocking call may not run past.
+     * 
+     */
+    class Deadline
+    {
+    private:
+        unsigned long start;
+        unsigned long duration;
+        bool never;
+
+        constexpr Deadline(unsigned long start, unsigned long duration, bool never) : start(start), duration(duration), never(never)
+        {}
+
+    public:
+        /**
+         * @brief Create a deadline that expires the given time from now.
+         * 
+         * @param milliseconds The time from now in milli seconds.
+         * @return Deadline The deadline.
+         */
+        static Deadline In(unsigned long milliseconds)
+        {
+            return Deadline(millis(), milliseconds, false);
+        }
+
+        /**
+         * @brief Create a deadline that never expires.
+         * 
+         * @return Deadline The deadline.
+         */
+        static constexpr Deadline Never()
+        {
+            return Deadline(0, 0, true);
+        }
+
+        /**
+         * @brief Check if the deadline has passed.
+         * 
+         * @return true If there is no time left.
+         * @return false If there is still time left.
+         */
+        bool Expired() const
+        {
+            return this->Remaining() == 0;
+        }
+
+        /**
+         * @brief Get the time that is left until the deadline.
+         * 
+         * @return unsigned long The time left in milli seconds, the maximum value if it never expires.
+         */
+        unsigned long Remaining() const
+        {
+            if (this->never)
+            {
+                return (unsigned long)-1;
+            }
+            unsigned long elapsed = millis() - this->start;
+            return (elapsed < this->duration) ? this->duration - elapsed : 0;
+        }
+    };
+
+    /**
+     * @brief View on a received frame that is still in the receive ring buffer.
+     * @details When the frame wraps around the end of the ring buffer it is split in two spans, otherwise the second
+     * span is empty. The view is valid until the frame is released or read.
+     * 
+     */
+    struct FrameView
+    {
+        const uint8_t *first;
+        size_t firstLength;
+        const uint8_t *second;
+        size_t secondLength;
+
+        /**
+         * @brief Get the total size of the frame.
+         * 
+         * @return size_t The amount of bytes in both spans.
+         */
+        size_t Size() const
+        {
+            return this->firstLength + this->secondLength;
+        }
+
+        /**
+         * @brief Get a byte of the frame, regardless in which span it is.
+         * 
+         * @param index The index of the byte in the frame.
+         * @return uint8_t The byte.
+         */
+        uint8_t operator[](size_t index) const
+        {
+            return (index < this->firstLength) ? this->first[index] : this->second[index - this->firstLength];
+        }
+
+        /**
+         * @brief Check the CRC-16 at the end of a frame that was send with `appendCrc`.
+         * 
+         * @return true If the frame is long enough to hold a CRC and it matches the data.
+         * @return false If the frame is corrupted or too short.
+         */
+        bool HasValidCrc() const
+        {
+            if (this->Size() < 2)
+            {
+                return false;
+            }
+            uint16_t crc = HC12Crc16::Update(HC12Crc16::kInitial, this->first, this->firstLength);
+            return HC12Crc16::Update(crc, this->second, this->secondLength) == 0;
+        }
+    };
+
+    /**
+     * @brief A single piece of a frame for the scatter gather writes.
+     * 
+     */
+    struct WriteSpan
+    {
+        const uint8_t *data;
+        size_t length;
+    };
+
+    /**
+     * @brief Called for every byte that `poll()` receives.
+     * 
+     */
+    typedef void (*ByteHandler)(uint8_t data, void *context);
+
+    /**
+     * @brief Called by `poll()` for every complete frame, the frame is released after all handlers have seen it.
+     * 
+     */
+    typedef void (*PacketHandler)(const FrameView &frame, void *context);
+
+    /**
+     * @brief Called when a command mode operation (like `UpdateParams()`) has finished.
+     * 
+     */
+    typedef void (*CommandCompleteHandler)(bool success, void *context);
+
+private:
+    /**
+     * @brief Small helper class that on construction enters command mode and on destruction leaves command mode.
+     * 
+     */
+    class CommandMode
+    {
+    private:
+        int pin;
+
+    public:
+        CommandMode(int pin) : pin(pin)
+        {
+            digitalWrite(pin, LOW);
+            delay(kCommandModeEnterTime);
+        }
+
+        ~CommandMode()
+        {
+            digitalWrite(pin, HIGH);
+            delay(kCommandModeExitTime);
+        }
+    };
+
+    /**
+     * @brief The AT commands a command mode session can consist of.
+     * @details `UpdateParams` runs the range from `UpdateBaudrate` to `RequestAll` in this order, skipping the
+     * steps that aren't needed at the moment they are reached.
+     * 
+     */
+    enum class CommandStep : uint8_t
+    {
+        Check,
+        RequestVersion,
+        Sleep,
+        Reset,
+        UpdateBaudrate,
+        UpdateChannel,
+        RequestChannel,
+        UpdateTransmitPower,
+        RequestTransmitPower,
+        UpdateOperationalMode,
+        RequestOperationalMode,
+        RequestBaudrate,
+        RequestAll
+    };
+
+    /**
+     * @brief Where the non-blocking command mode session is at.
+     * 
+     */
+    enum class CommandState : uint8_t
+    {
+        Idle,
+        Deferred,
+        Entering,
+        WaitingReply,
+        Exiting
+    };
+
+    /**
+     * @brief How the argument of an AT command is written after its fixed part.
+     * 
+     */
+    enum class CommandArgument : uint8_t
+    {
+        None,
+        Decimal,
+        ThreeDigits
+    };
+
+    /**
+     * @brief What has to follow the fixed prefix of a reply.
+     * 
+     */
+    enum class ReplyValue : uint8_t
+    {
+        None,
+        Decimal,
+        Dbm,
+        ModeAndBaudrate,
+        AllParameters,
+        Text
+    };
+
+    /**
+     * @brief What a valid reply does with the parameters.
+     * 
+     */
+    enum class CommandEffect : uint8_t
+    {
+        None,
+        Update,
+        Request,
+        Reset,
+        Version
+    };
+
+    /**
+     * @brief Describes a single AT command: how the request is written, what the reply looks like and which parameter
+     * (`Config` field) it is about. The requests are written and the replies parsed in place, without any `String`.
+     * 
+     */
+    struct CommandDescription
+    {
+        const char *request;
+        CommandArgument argument;
+        const char *reply;
+        ReplyValue value;
+        uint8_t lines;
+        CommandEffect effect;
+        uint8_t field;
+    };
+
+    /**
+     * @brief The AT protocol, one row per `CommandStep` in the same order.
+     * 
+     */
+    static const CommandDescription kCommandTable[(uint8_t)CommandStep::RequestAll + 1];
+
+    /**
+     * @brief Maximum length of a reply to an AT command that is kept.
+     * 
+     */
+    static constexpr uint8_t kMaxReplyLength = 64;
+
+    /**
+     * @brief Maximum length of an AT command (without the line ending).
+     * 
+     */
+    static constexpr uint8_t kMaxCommandLength = 16;
+
+    /**
+     * @brief Time in milli seconds added to the measured reply time of a known firmware before a reply is given up on.
      * 
      */
-    enum class Baudrates
-    {
-        BPS_1200 = 1200,
-        BPS_2400 = 2400,
-        BPS_4800 = 4800,
-        BPS_9600 = 9600,
-        BPS_19200 = 19200,
-        BPS_138400 = 138400,
-        BPS_57600 = 57600,
-        BPS_115200 = 115200
-    };
+    static constexpr unsigned long kCommandResponseMargin = 40UL;
 
-private:
     /**
-     * @brief Small helper class that on construction enters command mode and on destruction leaves command mode.
+     * @brief Accumulates a duration in milliseconds without losing the sub millisecond parts.
      * 
      */
-    class CommandMode
+    struct Airtime
     {
-    private:
-        int pin;
-
-    public:
-        CommandMode(int pin) : pin(pin)
-        {
-            digitalWrite(pin, LOW);
-            delay(40);
-        }
+        unsigned long millis = 0;
+        unsigned int micros = 0;
 
-        ~CommandMode()
+        void Add(unsigned long duration)
         {
-            digitalWrite(pin, HIGH);
-            delay(80);
+            duration += micros;
+            millis += duration / 1000UL;
+            micros = duration % 1000UL;
         }
     };
 
     /**
-     * @brief Util class that can help with properties that lazy updatable.
+     * @brief Fixed size ring buffer that holds whole frames, each prefixed with its length.
      * 
-     * @tparam T The type of the property to track.
      */
-    template<typename T>
-    class Updatable
+    class TransmitQueue
     {
     private:
-        T newValue;
-        T currentValue;
+        uint8_t buffer[HC12_TX_QUEUE_SIZE];
+        size_t head;
+        size_t count;
+
     public:
-        constexpr Updatable(T current) : newValue(current), currentValue(current)
+        TransmitQueue() : head(0), count(0)
         {}
 
         /**
-         * @brief Check if the new value is different from the current value.
+         * @brief Add a whole frame to the queue.
          * 
-         * @return true If the new value is different.
-         * @return false If the values are the same.
+         * @param data The data of the frame.
+         * @param size The size of the frame (max `kMaxFrameSize` bytes).
+         * @return true If the frame was queued.
+         * @return false If the frame doesn't fit in the queue.
          */
-        bool HasChanged() const
+        bool Push(const uint8_t *data, size_t size)
         {
-            return newValue != currentValue;
+            if (!this->Begin(size))
+            {
+                return false;
+            }
+            this->Append(data, size);
+            return true;
         }
 
         /**
-         * @brief Return the current value.
+         * @brief Start a frame of the given size, the data is then added with `Append`.
          * 
-         * @return T The current value.
+         * @param size The size of the whole frame (max `kMaxFrameSize` bytes).
+         * @return true If the frame fits in the queue.
+         * @return false If the frame doesn't fit in the queue, nothing was added then.
          */
-        T Current() const
+        bool Begin(size_t size)
         {
-            return currentValue;
+            if (size == 0 || size > kMaxFrameSize || size + 1 > HC12_TX_QUEUE_SIZE - count)
+            {
+                return false;
+            }
+            this->PushByte((uint8_t)size);
+            return true;
         }
 
         /**
-         * @brief Return what is going to be the new value.
+         * @brief Add data to the frame that was started with `Begin`.
          * 
-         * @return T The new value.
+         * @param data The data to add.
+         * @param size The amount of bytes to add.
          */
-        T& New()
+        void Append(const uint8_t *data, size_t size)
         {
-            return currentValue;
+            while (size-- > 0)
+            {
+                this->PushByte(*data++);
+            }
         }
 
         /**
-         * @brief Return what is going to be the new value.
+         * @brief Take the length prefix of the next frame from the queue.
          * 
-         * @return T The new value.
+         * @return uint8_t The length of the next frame, 0 if the queue is empty.
          */
-        const T& New() const
+        uint8_t PopLength()
         {
-            return currentValue;
+            if (this->count == 0)
+            {
+                return 0;
+            }
+            uint8_t length = this->buffer[this->head];
+            this->Consume(1);
+            return length;
         }
 
         /**
-         * @brief Mark the new value is the current up to date value.
+         * @brief Get the next bytes that are contiguous in memory.
          * 
+         * @param data Set to the start of the bytes.
+         * @return size_t The amount of contiguous bytes.
          */
-        void MarkUpdated()
+        size_t Front(const uint8_t *&data) const
         {
-            currentValue = newValue;
+            data = &this->buffer[this->head];
+            size_t contiguous = HC12_TX_QUEUE_SIZE - this->head;
+            return (this->count < contiguous) ? this->count : contiguous;
         }
 
         /**
-         * @brief Set the current value without changing the potential new value.
+         * @brief Remove bytes from the front of the queue.
          * 
-         * @param current The new current value.
+         * @param size The amount of bytes to remove.
          */
-        void ForceUpdateCurrent(T current)
+        void Consume(size_t size)
+        {
+            this->head = (this->head + size) % HC12_TX_QUEUE_SIZE;
+            this->count -= size;
+        }
+
+        bool Empty() const
         {
-            this->currentValue = current;
+            return this->count == 0;
         }
+
+    private:
+        void PushByte(uint8_t data)
+        {
+            this->buffer[(this->head + this->count) % HC12_TX_QUEUE_SIZE] = data;
+            this->count++;
+        }
+    };
+
+    /**
+     * @brief The events a handler can be registered for.
+     * 
+     */
+    enum class EventType : uint8_t
+    {
+        None,
+        Byte,
+        Packet,
+        CommandComplete
+    };
+
+    /**
+     * @brief A registered event handler, the function that is used depends on the type.
+     * 
+     */
+    struct EventHandler
+    {
+        EventType type;
+        union
+        {
+            ByteHandler onByte;
+            PacketHandler onPacket;
+            CommandCompleteHandler onCommandComplete;
+        } function;
+        void *context;
+        unsigned long sequence;
     };
 
 private:
     Stream &serial;
     int setPin;
 
-    Updatable<unsigned int> baudrate;
-    Updatable<OperationalMode> operationalMode;
-    Updatable<int> channel;
-    Updatable<TransmitPower> transmitPower;
+    Config config;
+    Config pendingConfig;
+    uint8_t dirtyConfig;
+
+    EnergyProfile energyProfile;
+    unsigned long energyStart;
+    Airtime transmitTime;
+    Airtime receiveTime;
+    unsigned long commandMillis;
+    unsigned long sleepMillis;
+    unsigned long sleepStart;
+    bool sleeping;
+    float transmitCharge;
+    float idleCharge;
+    unsigned long idleAccounted;
+    unsigned long bytesTransmitted;
+    unsigned long bytesReceived;
+
+    TransmitQueue transmitQueues[HC12_TX_PRIORITIES];
+    uint8_t activeQueue;
+    uint8_t activeRemaining;
+    unsigned long uartBusy;
+    unsigned long airBusy;
+    unsigned long transmitUpdated;
+
+    uint8_t receiveBuffer[HC12_RX_BUFFER_SIZE];
+    size_t receiveHead;
+    size_t receiveCount;
+    size_t frameLengths[HC12_RX_MAX_FRAMES];
+    uint8_t frameHead;
+    uint8_t frameCount;
+    size_t openFrameLength;
+    unsigned long lastReceive;
+    unsigned long savedBytes;
+
+    EventHandler handlers[HC12_MAX_HANDLERS];
+    unsigned long handlerSequence;
+
+    Deadline commandDeadline;
+    CommandState commandState;
+    CommandStep commandStep;
+    CommandStep commandLastStep;
+    bool commandSuccess;
+    unsigned long commandSessionStart;
+    unsigned long commandStateStart;
+    unsigned long commandTimeout;
+    char commandReply[kMaxReplyLength + 1];
+    uint8_t commandReplyLength;
+    uint8_t commandReplyLines;
+    uint8_t commandDirty;
+    uint8_t commandReported;
+    Capabilities capabilities;
 
 public:
     /**
@@ -202,11 +976,14 @@ public:
      * @param serial The stream to use for communication with the module.
      * @param setPin The pin that is used to set the module in command mode (also know as SET or KEY pin).
      * @param baud The default baudrate that the module is currently set at.
-     * @param mode The default operational mode the module is in.
+     * @param mode The default operational mode the module is in (FU3 is the factory default).
      * @param channel The default channel for the module.
      * @param power The default transmit power of the module.
+     * @param layout Leave the default, it makes the link fail when the sketch and the library use other sizes (see
+     * `HC12Layout`).
      */
-    HC12(Stream &serial, unsigned int setPin, Baudrates baud = Baudrates::BPS_9600, OperationalMode mode = OperationalMode::FU2, unsigned int channel = 1, TransmitPower power = TransmitPower::mW_100_0);
+    HC12(Stream &serial, unsigned int setPin, Baudrates baud = Baudrates::BPS_9600, OperationalMode mode = OperationalMode::FU3, unsigned int channel = 1, TransmitPower power = TransmitPower::mW_100_0,
+         const uint8_t &layout = HC12BuildLayout::kCheck);
 
     /**
      * @brief Setup and try to contact the HC12 module.
@@ -216,33 +993,67 @@ public:
      */
     bool begin();
 
+    /**
+     * @brief Setup and try to contact the HC12 module, giving up when the deadline expires.
+     * @details With `detectCapabilities` the firmware version is requested as well, and the capability profile for it
+     * is used from then on (see `GetCapabilities`). A module that doesn't answer `AT+V` keeps the basic profile.
+     * 
+     * @param deadline The time the call must have returned by (including leaving command mode).
+     * @param detectCapabilities Request the firmware version and pick the capabilities to use.
+     * @return true if the module replied and is available.
+     * @return false if the module never replied, only garbage was received or there wasn't enough time.
+     */
+    bool begin(Deadline deadline, bool detectCapabilities = false);
+
+    /**
+     * @brief Get what the firmware of the module supports, to store it together with `GetConfig()`.
+     * 
+     * @return Capabilities The capabilities in use, all zero if they were never detected.
+     */
+    Capabilities GetCapabilities() const;
+
+    /**
+     * @brief Use capabilities that were detected (and stored) before, instead of detecting them again.
+     * 
+     * @param capabilities The capabilities to use.
+     */
+    void SetCapabilities(const Capabilities &capabilities);
+
     /**
      * @brief Configure the baudrate to be set on the next UpdateParams call.
      * 
      * @param baudrate The new baudrate to set then.
+     * @return true If the baudrate is prepared.
+     * @return false If it isn't a supported baudrate, nothing is changed then.
      */
-    void PrepareBaudrate(Baudrates baudrate);
+    bool PrepareBaudrate(Baudrates baudrate);
     
     /**
      * @brief Configure the new operation mode to be set on the next UpdateParams call.
      * 
      * @param mode The new operation mode to set then.
+     * @return true If the mode is prepared.
+     * @return false If it isn't a valid mode, nothing is changed then.
      */
-    void PrepareOperationalMode(OperationalMode mode);
+    bool PrepareOperationalMode(OperationalMode mode);
     
     /**
      * @brief Configure the channel to be set on the next UpdateParams call.
      * 
-     * @param channel The new channel to set then.
+     * @param channel The new channel to set then (1 to 127).
+     * @return true If the channel is prepared.
+     * @return false If the channel is out of range, nothing is changed then.
      */
-    void PrepareChannel(int channel);
+    bool PrepareChannel(int channel);
     
     /**
      * @brief Configure the transmit power to be set on the next UpdateParams call.
      * 
      * @param power The new transmit power to set then.
+     * @return true If the transmit power is prepared.
+     * @return false If it isn't a valid transmit power, nothing is changed then.
      */
-    void PrepareTransmitPower(TransmitPower power);
+    bool PrepareTransmitPower(TransmitPower power);
 
     /**
      * @brief Update the module with new parameter settings and retrieve the ones that aren't updated.
@@ -252,6 +1063,30 @@ public:
      */
     bool UpdateParams();
 
+    /**
+     * @brief Update the module with new parameter settings and retrieve the ones that aren't updated, giving up on the
+     * remaining commands when the deadline expires.
+     * 
+     * @param deadline The time the call must have returned by (including leaving command mode).
+     * @return true if the syncronization was a success.
+     * @return false if the syncronization was a failure or didn't finish in time.
+     */
+    bool UpdateParams(Deadline deadline);
+
+    /**
+     * @brief Start updating the module parameters like `UpdateParams` but without blocking, `poll()` does the work.
+     * @details The SET pin only goes low once all queued frames are on air and nothing has been received for a frame
+     * gap, so no packet is cut in half, but never later than `kMaxCommandDeferral` after the start. Until then the
+     * radio keeps working normally. Once in command mode the serial belongs to the command mode: `write` doesn't send
+     * anything and the read functions only return what already is in the receive ring buffer. The result is available
+     * through `LastCommandSucceeded()` or the `onCommandComplete` handlers once `IsCommandBusy()` returns false.
+     * 
+     * @param deadline The time the session must have finished by (including leaving command mode).
+     * @return true If the session was started.
+     * @return false If another session is still running or there isn't enough time.
+     */
+    bool BeginUpdateParams(Deadline deadline = Deadline::Never());
+
     /**
      * @brief Retrieve the currently set baudrate.
      * 
@@ -280,6 +1115,23 @@ public:
      */
     TransmitPower GetTransmitPower();
 
+    /**
+     * @brief Get all the parameters the module is now using, for example to store them or send them to other nodes.
+     * 
+     * @return Config The current parameters.
+     */
+    Config GetConfig() const;
+
+    /**
+     * @brief Configure all parameters at once to be set on the next UpdateParams call.
+     * @details Only the parameters that differ from the current ones are send to the module.
+     * 
+     * @param config The new parameters.
+     * @return true If the parameters are prepared.
+     * @return false If any of the parameters is invalid (see `Config::IsValid()`), nothing is changed then.
+     */
+    bool PrepareConfig(const Config &config);
+
     /**
      * @brief Put the module into sleep until the next time the module enters the command mode (using like `UpdateParams()`).
      * 
@@ -288,6 +1140,24 @@ public:
      */
     bool Sleep();
 
+    /**
+     * @brief Put the module into sleep, giving up when the deadline expires.
+     * 
+     * @param deadline The time the call must have returned by (including leaving command mode).
+     * @return true if the module was successfully put into sleep mode.
+     * @return false if the module failed to go into sleep mode or there wasn't enough time.
+     */
+    bool Sleep(Deadline deadline);
+
+    /**
+     * @brief Start putting the module into sleep like `Sleep` but without blocking, `poll()` does the work.
+     * 
+     * @param deadline The time the session must have finished by (including leaving command mode).
+     * @return true If the session was started.
+     * @return false If another session is still running or there isn't enough time.
+     */
+    bool BeginSleep(Deadline deadline = Deadline::Never());
+
     /**
      * @brief Resets all parameters to their default values.
      * 
@@ -296,6 +1166,233 @@ public:
      */
     bool Reset();
 
+    /**
+     * @brief Resets all parameters to their default values, giving up when the deadline expires.
+     * 
+     * @param deadline The time the call must have returned by (including leaving command mode).
+     * @return true if all the values were successfully reset.
+     * @return false if the module and it's values failed to be reset or there wasn't enough time.
+     */
+    bool Reset(Deadline deadline);
+
+    /**
+     * @brief Start resetting the module like `Reset` but without blocking, `poll()` does the work.
+     * 
+     * @param deadline The time the session must have finished by (including leaving command mode).
+     * @return true If the session was started.
+     * @return false If another session is still running or there isn't enough time.
+     */
+    bool BeginReset(Deadline deadline = Deadline::Never());
+
+#ifdef HC12_HAS_COROUTINES
+    /**
+     * @brief `co_await` versions of `UpdateParams`, `Sleep` and `Reset` (needs HC12Async.h).
+     * @details The coroutine is resumed from `poll()` once the command mode session has finished, the result of the
+     * `co_await` is whether it succeeded.
+     * 
+     * @param deadline The time the session must have finished by (including leaving command mode).
+     * @return HC12CommandAwaiter The awaitable session.
+     */
+    HC12CommandAwaiter UpdateParamsAsync(Deadline deadline = Deadline::Never());
+    HC12CommandAwaiter SleepAsync(Deadline deadline = Deadline::Never());
+    HC12CommandAwaiter ResetAsync(Deadline deadline = Deadline::Never());
+
+    /**
+     * @brief `co_await` version of `ReadPacket` (needs HC12Async.h).
+     * @details The coroutine is resumed from `poll()` with a view on the frame, which is released once the coroutine
+     * suspends again.
+     * 
+     * @return HC12PacketAwaiter The awaitable frame.
+     */
+    HC12PacketAwaiter ReadPacketAsync();
+#endif
+
+    /**
+     * @brief Check if a command mode session is running.
+     * 
+     * @return true If the module is (waiting to enter, entering or leaving) command mode.
+     * @return false If the module is in its normal mode.
+     */
+    bool IsCommandBusy() const;
+
+    /**
+     * @brief Get the result of the last finished command mode session.
+     * 
+     * @return true If all the commands of the last session succeeded.
+     * @return false If a command failed or the session ran out of time.
+     */
+    bool LastCommandSucceeded() const;
+
+    /**
+     * @brief Get the estimated time it takes the module to send a single byte over the air.
+     * @details Based on the air data rate of the current operational mode (and baudrate for FU3).
+     * 
+     * @return unsigned long The airtime of a single byte in micro seconds.
+     */
+    unsigned long GetByteAirtime() const;
+
+    /**
+     * @brief Set the current draw table used for the energy estimate.
+     * 
+     * @param profile The currents of the module in each state.
+     */
+    void SetEnergyProfile(const EnergyProfile &profile);
+
+    /**
+     * @brief Get the time spent in each state and the energy estimate based on the energy profile.
+     * 
+     * @return EnergyStats The accumulated statistics.
+     */
+    EnergyStats GetEnergyStats() const;
+
+    /**
+     * @brief Clear the energy statistics and start accounting from now on.
+     * 
+     */
+    void ResetEnergyStats();
+
+    /**
+     * @brief Queue a whole frame to be send by `poll()`.
+     * @details Frames are send in order of priority, a frame is never interrupted by another frame but at each frame
+     * boundary the highest priority queue that has data goes first. Avoid mixing this with direct `write` calls while
+     * a frame is still being send.
+     * 
+     * @param buffer The data of the frame.
+     * @param size The size of the frame (max `kMaxFrameSize` bytes, `HC12_TX_QUEUE_SIZE` - 1 and never more than 255).
+     * @param priority The priority of the frame, `kHighestPriority` goes first.
+     * @return true If the frame was queued.
+     * @return false If the queue of that priority is full or the priority is invalid.
+     */
+    bool Enqueue(const uint8_t *buffer, size_t size, uint8_t priority = kLowestPriority);
+
+    /**
+     * @brief Queue a frame that is made of multiple spans (like a header and a payload) without first copying them
+     * into a temporary buffer.
+     * 
+     * @param spans The pieces of the frame, in order.
+     * @param count The amount of spans.
+     * @param priority The priority of the frame, `kHighestPriority` goes first.
+     * @param appendCrc Add a CRC-16 over the whole frame at the end (it counts for the `kMaxFrameSize` limit).
+     * @return true If the frame was queued.
+     * @return false If the queue of that priority is full or the priority is invalid.
+     */
+    bool Enqueue(const WriteSpan *spans, size_t count, uint8_t priority = kLowestPriority, bool appendCrc = false);
+
+    /**
+     * @brief Write multiple spans (like a header and a payload) directly to the module in one pass.
+     * 
+     * @param spans The pieces of the data, in order.
+     * @param count The amount of spans.
+     * @param appendCrc Add a CRC-16 over all the spans at the end.
+     * @return size_t The amount of bytes written, including the CRC.
+     */
+    size_t writev(const WriteSpan *spans, size_t count, bool appendCrc = false);
+
+    /**
+     * @brief Check if all the queued frames have been handed to the module.
+     * 
+     * @return true If there is nothing queued anymore.
+     * @return false If there are still frames (or part of a frame) waiting.
+     */
+    bool IsTransmitQueueEmpty() const;
+
+    /**
+     * @brief Does the background work of the driver without blocking. Call this as often as possible.
+     * @details Advances a running command mode session. Otherwise it hands queued frames to the module at the pace it
+     * can send them over the air and moves received data into the receive ring buffer, splitting it into frames at
+     * each gap of `kFrameGapBytes` byte times.
+     * The event handlers are called from here. Call it from the same task as every other function of the instance:
+     * a serial receive callback (like `HardwareSerial::onReceive` on the ESP32) runs in another task, at the same time
+     * as `read()`, `PeekFrame()` or `write()`, and nothing in here is locked (see `HC12ThreadSafe` to share a radio).
+     * 
+     */
+    void poll();
+
+    /**
+     * @brief Get the amount of complete frames in the receive ring buffer.
+     * 
+     * @return uint8_t The amount of frames.
+     */
+    uint8_t FramesAvailable() const;
+
+    /**
+     * @brief Get a view on the oldest complete frame without copying it out of the receive ring buffer.
+     * 
+     * @param view Set to the spans of the frame.
+     * @return true If there was a complete frame.
+     * @return false If there isn't a complete frame (yet).
+     */
+    bool PeekFrame(FrameView &view) const;
+
+    /**
+     * @brief Remove the oldest complete frame from the receive ring buffer, invalidating its view.
+     * 
+     */
+    void ReleaseFrame();
+
+    /**
+     * @brief Wait (while calling `poll()`) until a complete frame has been received.
+     * @details This doesn't release the frame, call `ReleaseFrame()` when done with it. Frames are never returned
+     * here when a packet handler is registered, since `poll()` releases them.
+     * 
+     * @param frame Set to the spans of the frame.
+     * @param deadline The time to give up waiting.
+     * @return true If a frame was received.
+     * @return false If the deadline expired first.
+     */
+    bool ReadPacket(FrameView &frame, Deadline deadline);
+
+    /**
+     * @brief Get the amount of received bytes that were kept while entering command mode.
+     * @details Everything the module sends before the first command of a session is user data that was still on its
+     * way, it's moved into the receive ring buffer (as its own frame) instead of being dropped with the replies.
+     * 
+     * @return unsigned long The amount of bytes since `begin()` (or `ResetEnergyStats()`).
+     */
+    unsigned long GetSavedBytes() const;
+
+    /**
+     * @brief Register a function that is called by `poll()` for every received byte.
+     * 
+     * @param handler The function to call.
+     * @param context Passed to the handler as is.
+     * @return true If the handler was registered.
+     * @return false If the handler table (`HC12_MAX_HANDLERS`) is full.
+     */
+    bool onByte(ByteHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Register a function that is called by `poll()` for every complete received frame.
+     * @details Once a packet handler is registered, `poll()` releases every frame after the handlers have been
+     * called, so the frame view is only valid during the call.
+     * 
+     * @param handler The function to call.
+     * @param context Passed to the handler as is.
+     * @return true If the handler was registered.
+     * @return false If the handler table (`HC12_MAX_HANDLERS`) is full.
+     */
+    bool onPacket(PacketHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Register a function that is called when a command mode operation has finished.
+     * 
+     * @param handler The function to call.
+     * @param context Passed to the handler as is.
+     * @return true If the handler was registered.
+     * @return false If the handler table (`HC12_MAX_HANDLERS`) is full.
+     */
+    bool onCommandComplete(CommandCompleteHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Remove a handler that was registered with the same function and context.
+     * 
+     * @return true If the handler was found and removed.
+     * @return false If no such handler was registered.
+     */
+    bool RemoveHandler(ByteHandler handler, void *context = nullptr);
+    bool RemoveHandler(PacketHandler handler, void *context = nullptr);
+    bool RemoveHandler(CommandCompleteHandler handler, void *context = nullptr);
+
     virtual int available() override;
     virtual int read() override;
     virtual int peek() override;
@@ -303,6 +1400,99 @@ public:
     virtual size_t write(const uint8_t *buffer, size_t size) override;
     virtual void flush() override;
 
+    /**
+     * @brief Estimate how many bytes the module can still take without overrunning its buffer.
+     * @details The module buffer is modelled as the bytes written that haven't been send over the air yet. A byte goes
+     * on air after it passed the UART (at the serial baudrate) and the bytes before it are send (at the air rate of the
+     * current mode, see `GetByteAirtime()`).
+     * 
+     * @return int The amount of bytes that can be written now, 0 in command mode.
+     */
+    virtual int availableForWrite() override;
+
+    /**
+     * @brief Check if everything that was written or queued has been send over the air.
+     * @details `flush()` only waits for the UART, the module can then still be sending for a long time in the slow
+     * modes (hundreds of milli seconds in FU4). Sleeping or switching channel before this returns true cuts off the
+     * last packet. This doesn't block (it doesn't call `flush()` either), call it from the loop (together with `poll()`)
+     * until it returns true.
+     * 
+     * @return true If the transmit queues are empty and, by the model, the last byte has passed the UART, the air and
+     * `kModulePacketLatency`.
+     * @return false If the module is still sending.
+     */
+    bool airFlush();
+
+    /**
+     * @brief Wait (while calling `poll()`) until everything that was written or queued has been send over the air.
+     * 
+     * @param deadline The time to give up waiting.
+     * @return true If everything has been send.
+     * @return false If the deadline expired first.
+     */
+    bool airFlush(Deadline deadline);
+
+    /**
+     * @brief Read multiple bytes at once, first from the receive ring buffer and then from the serial.
+     * @details Like `Stream::readBytes` it waits at most the timeout set with `setTimeout` for the data from the serial.
+     * 
+     * @param buffer The buffer to read into.
+     * @param length The maximum amount of bytes to read.
+     * @return size_t The amount of bytes read.
+     */
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        return this->readBytes((char *)buffer, length);
+    }
+
+    /**
+     * @brief Read multiple bytes at once, waiting for the data at most until the deadline.
+     * 
+     * @param buffer The buffer to read into.
+     * @param length The maximum amount of bytes to read.
+     * @param deadline The time to stop waiting for more data.
+     * @return size_t The amount of bytes read.
+     */
+    size_t readBytes(uint8_t *buffer, size_t length, Deadline deadline);
+
+    /**
+     * @brief Read multiple bytes at once until the terminator is found, the terminator itself is removed but not stored.
+     * @details Like `Stream::readBytesUntil` it waits at most the timeout set with `setTimeout` for the data from the serial.
+     * 
+     * @param terminator The byte to stop at.
+     * @param buffer The buffer to read into.
+     * @param length The maximum amount of bytes to read.
+     * @return size_t The amount of bytes read (without the terminator).
+     */
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length)
+    {
+        return this->readBytesUntil(terminator, (char *)buffer, length);
+    }
+
+    /**
+     * @brief Read multiple bytes at once until the terminator is found, waiting for the data at most until the deadline.
+     * 
+     * @param terminator The byte to stop at.
+     * @param buffer The buffer to read into.
+     * @param length The maximum amount of bytes to read.
+     * @param deadline The time to stop waiting for more data.
+     * @return size_t The amount of bytes read (without the terminator).
+     */
+    size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length, Deadline deadline);
+
+    /**
+     * @brief Look ahead at multiple bytes without removing them.
+     * @details Moves the data that is waiting in the serial into the receive ring buffer first, so at most
+     * `HC12_RX_BUFFER_SIZE` bytes can be looked at. No frames are closed and no packet handlers are called.
+     * 
+     * @param buffer The buffer to copy the bytes into.
+     * @param length The maximum amount of bytes to copy.
+     * @return size_t The amount of bytes copied.
+     */
+    size_t peek(uint8_t *buffer, size_t length);
+
     /**
      * @brief Looks on each baudrate if the module replies to the status command.
      * 
@@ -314,44 +1504,43 @@ public:
     template <typename T = HardwareSerial>
     static unsigned int FindBaudrateForModule(T &ser, int cmdPin)
     {
+        return FindBaudrateForModule(ser, cmdPin, Deadline::Never());
+    }
+
+    /**
+     * @brief Looks on each baudrate if the module replies to the status command, until the deadline expires.
+     * 
+     * @tparam T The serial to use (but MUST have `updateBaudRate(int baudrate)` and inherit from Stream).
+     * @param ser The serial object to use.
+     * @param cmdPin The pin that is used to set the module into command mode (also known as the SET or KEY pin)
+     * @param deadline The time the search must have returned by (including leaving command mode).
+     * @return unsigned int The baudrate the module is found at. 0 if the module could not be found in time.
+     */
+    template <typename T = HardwareSerial>
+    static unsigned int FindBaudrateForModule(T &ser, int cmdPin, Deadline deadline)
+    {
+        // 9600, 115200 and 19200 are much more common so they go first. Then 4800 since it is the fallback for FU3
+        // but still supported by all other modes, and then the other 'regular' baudrates.
+        const unsigned int kSearchOrder[] = {9600, 115200, 19200, 4800, 1200, 2400, 138400, 57600};
+        if (deadline.Remaining() <= kCommandModeEnterTime + kCommandModeExitTime)
+        {
+            return 0;
+        }
         CommandMode cmd(cmdPin);
-        // Put these baudrates up front since they are much more common.
-        ser.updateBaudRate(9600);
-        Serial.println(F("Looking at baud: 9600."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 9600;
-        ser.updateBaudRate(115200);
-        Serial.println(F("Looking at baud: 115200."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 115200;
-        ser.updateBaudRate(19200);
-        Serial.println(F("Looking at baud: 19200."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 19200;
-
-        // Prioritize this baudrate since this baudrate is fallback for FU3 but still supported by all other modes
-        ser.updateBaudRate(4800);
-        Serial.println(F("Looking at baud: 4800."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 4800;
-
-        // Other 'regular' baudrates.
-        ser.updateBaudRate(1200);
-        Serial.println(F("Looking at baud: 1200."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 1200;
-        ser.updateBaudRate(2400);
-        Serial.println(F("Looking at baud: 2400."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 2400;
-        ser.updateBaudRate(138400);
-        Serial.println(F("Looking at baud: 138400."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 138400;
-        ser.updateBaudRate(57600);
-        Serial.println(F("Looking at baud: 57600."));
-        if (SendCommandAndGetOK(ser, "AT"))
-            return 57600;
+        for (unsigned int baud : kSearchOrder)
+        {
+            unsigned long timeout = CommandTimeout(deadline);
+            if (timeout == 0)
+            {
+                break;
+            }
+            ser.updateBaudRate(baud);
+            Serial.print(F("Looking at baud: "));
+            Serial.print(baud);
+            Serial.println(F("."));
+            if (SendCommandAndGetOK(ser, "AT", timeout))
+                return baud;
+        }
         return 0;
     }
 
@@ -390,6 +1579,18 @@ public:
             power == TransmitPower::mW_100_0);
     }
 
+    /**
+     * @brief Checks if the given channel is one the module supports.
+     * 
+     * @param channel The channel to check.
+     * @return true If the channel is between 1 and 127.
+     * @return false If the channel is out of range.
+     */
+    static constexpr bool IsChannel(int channel)
+    {
+        return channel >= 1 && channel <= 127;
+    }
+
     /**
      * @brief Checks the given mode if it is a valid baudrate.
      * 
@@ -411,34 +1612,71 @@ public:
     }
 
 private:
-    static void SendCommand(Stream &serial, const String &command);
-    static bool SendCommandAndGetOK(Stream &serial, const String &command);
-    static String SendCommandAndGetResult(Stream &serial, const String &command);
+    static void SendCommand(Stream &serial, const char *command);
+    static bool SendCommandAndGetOK(Stream &serial, const String &command, unsigned long timeout = kMaxCommandResponseTime);
+    static String SendCommandAndGetResult(Stream &serial, const String &command, unsigned long timeout = kMaxCommandResponseTime);
+    static size_t ReadSerial(Stream &serial, uint8_t *buffer, size_t length, const Deadline &deadline, int terminator, bool &terminated);
     static bool DbmToTransmitPower(int dbm, TransmitPower &power);
+    static size_t FormatCommand(const CommandDescription &command, const Config &config, char *buffer);
+    static bool ParseReply(const CommandDescription &command, const char *reply, Config &value, uint8_t &fields);
+    static const char *ParseNumber(const char *text, long &number);
+    static bool SetConfigValue(Config &config, uint8_t field, long number);
+    static unsigned long ConfigValue(const Config &config, uint8_t field);
+    static bool ParseVersion(const char *reply, Capabilities &capabilities);
 
-    void SendCommand(const String &command)
-    {
-        this->SendCommand(this->serial, command);
-    }
-
-    bool SendCommandAndGetOK(const String &command)
+    /**
+     * @brief Get the time a command may wait for its response, leaving enough time to exit command mode.
+     * 
+     * @param deadline The deadline of the whole command mode session.
+     * @return unsigned long The response timeout, 0 if there isn't enough time left for another command.
+     */
+    static unsigned long CommandTimeout(const Deadline &deadline)
     {
-        return this->SendCommandAndGetOK(this->serial, command);
+        unsigned long remaining = deadline.Remaining();
+        if (remaining <= kCommandModeExitTime)
+        {
+            return 0;
+        }
+        remaining -= kCommandModeExitTime;
+        return (remaining < kMaxCommandResponseTime) ? remaining : kMaxCommandResponseTime;
     }
 
-    String SendCommandAndGetResult(const String &command)
-    {
-        return this->SendCommandAndGetResult(this->serial, command);
-    }
+    bool BeginCommandSession(CommandStep first, CommandStep last, const Deadline &deadline);
+    bool WaitForCommandSession();
+    void PumpCommand();
+    void SendNextCommand();
+    void FinishCommand();
+    void LeaveCommandMode();
+    void EnterCommandState(CommandState state);
+    bool IsCommandStepNeeded(CommandStep step) const;
+    bool HandleCommandReply(CommandStep step, const char *reply, unsigned long latency);
+    void StoreConfig(const Config &value, uint8_t fields);
 
-    bool UpdateBaudrate();
-    bool RequestBaudrate();
-    bool UpdateOperationalMode();
-    bool RequestOperationalMode();
-    bool UpdateChannel();
-    bool RequestChannel();
-    bool UpdateTransmitPower();
-    bool RequestTransmitPower();
+    void WakeUp();
+    void AccountTransmit(size_t size);
+    void AccountIdle();
+    unsigned long IdleMillis(unsigned long now) const;
+    void AccountReceive(size_t size);
+    void UpdateTransmitModel();
+    unsigned long GetUartByteTime() const;
+    unsigned int ModuleBacklog();
+    unsigned int UartBacklog();
+    void PumpTransmitQueues();
+    void PumpReceive();
+    unsigned long FrameGap() const;
+    bool IsTrafficIdle();
+    bool IsInCommandMode() const;
+    void EnterCommandMode();
+    size_t ReceiveAvailable();
+    void CloseOpenFrame();
+    void SaveReceived();
+    void ConsumeReceived(size_t size);
+    size_t CopyReceived(uint8_t *buffer, size_t size) const;
+    EventHandler *AddHandler(EventType type, void *context);
+    void DispatchPackets();
+    bool FireCommandComplete(bool success);
+    bool HasHandler(EventType type) const;
+    bool IsHandlerActive(const EventHandler &entry, EventType type, unsigned long dispatch) const;
 };
 
 #endif // INCLUDE_ARDUINO_HC12_H
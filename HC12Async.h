@@ -0,0 +1,187 @@
+/**
+ * @file HC12Async.h
+ * @author Giel Willemsen
+ * @brief C++20 coroutine support for the HC12.
+ * @version 0.1 2026-10-17 Initial version with awaitable command mode sessions and received packets.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_ASYNC_H
+#define INCLUDE_ARDUINO_HC12_ASYNC_H
+
+#include "Arduino.h"
+#include "HC12.h"
+
+#ifdef HC12_HAS_COROUTINES
+#include <coroutine>
+
+/**
+ * @brief Minimal coroutine type for code that `co_await`s the HC12. It starts right away and cleans itself up when it
+ * returns, so it is fire and forget.
+ *
+ */
+class HC12Task
+{
+public:
+    struct promise_type
+    {
+        HC12Task get_return_object()
+        {
+            return HC12Task();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {}
+
+        void unhandled_exception()
+        {
+            abort();
+        }
+    };
+};
+
+/**
+ * @brief Awaits a non-blocking command mode session, the result of `co_await` is whether it succeeded.
+ * @details The coroutine is resumed from the `poll()` that finishes the session. The awaiter only uses a slot in the
+ * handler table of the HC12 while suspended, so nothing is allocated besides the coroutine frame itself.
+ *
+ */
+class HC12CommandAwaiter
+{
+public:
+    typedef bool (HC12::*BeginFunction)(HC12::Deadline deadline);
+
+private:
+    HC12 &radio;
+    BeginFunction begin;
+    HC12::Deadline deadline;
+    std::coroutine_handle<> handle;
+    bool started;
+    bool result;
+
+public:
+    HC12CommandAwaiter(HC12 &radio, BeginFunction begin, HC12::Deadline deadline)
+        : radio(radio), begin(begin), deadline(deadline), handle(), started(false), result(false)
+    {}
+
+    bool await_ready()
+    {
+        // Register first, so a full handler table is known before the session is started.
+        if (!this->radio.onCommandComplete(&HC12CommandAwaiter::OnComplete, this))
+        {
+            return true;
+        }
+        this->started = (this->radio.*(this->begin))(this->deadline);
+        if (!this->started)
+        {
+            this->radio.RemoveHandler(&HC12CommandAwaiter::OnComplete, this);
+        }
+        return !this->started;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        this->handle = handle;
+    }
+
+    bool await_resume() const
+    {
+        return this->started && this->result;
+    }
+
+private:
+    static void OnComplete(bool success, void *context)
+    {
+        HC12CommandAwaiter *self = static_cast<HC12CommandAwaiter *>(context);
+        self->result = success;
+        self->radio.RemoveHandler(&HC12CommandAwaiter::OnComplete, context);
+        self->handle.resume();
+    }
+};
+
+/**
+ * @brief Awaits the next received frame, the result of `co_await` is a view on it.
+ * @details The coroutine is resumed from the `poll()` that received the frame. The frame is released as soon as the
+ * coroutine suspends again (or returns), so the view must not be kept across another `co_await`.
+ *
+ */
+class HC12PacketAwaiter
+{
+private:
+    HC12 &radio;
+    std::coroutine_handle<> handle;
+    HC12::FrameView frame;
+    bool registered;
+
+public:
+    HC12PacketAwaiter(HC12 &radio) : radio(radio), handle(), frame{nullptr, 0, nullptr, 0}, registered(false)
+    {}
+
+    bool await_ready()
+    {
+        // Frames that are already waiting are handed over by the next poll() as well, so the view always behaves the same.
+        this->registered = this->radio.onPacket(&HC12PacketAwaiter::OnPacket, this);
+        return !this->registered;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        this->handle = handle;
+    }
+
+    /**
+     * @brief Get the received frame.
+     *
+     * @return HC12::FrameView The frame, empty if the handler table of the HC12 was full.
+     */
+    HC12::FrameView await_resume() const
+    {
+        return this->frame;
+    }
+
+private:
+    static void OnPacket(const HC12::FrameView &frame, void *context)
+    {
+        HC12PacketAwaiter *self = static_cast<HC12PacketAwaiter *>(context);
+        self->frame = frame;
+        self->radio.RemoveHandler(&HC12PacketAwaiter::OnPacket, context);
+        self->handle.resume();
+    }
+};
+
+inline HC12CommandAwaiter HC12::UpdateParamsAsync(Deadline deadline)
+{
+    return HC12CommandAwaiter(*this, &HC12::BeginUpdateParams, deadline);
+}
+
+inline HC12CommandAwaiter HC12::SleepAsync(Deadline deadline)
+{
+    return HC12CommandAwaiter(*this, &HC12::BeginSleep, deadline);
+}
+
+inline HC12CommandAwaiter HC12::ResetAsync(Deadline deadline)
+{
+    return HC12CommandAwaiter(*this, &HC12::BeginReset, deadline);
+}
+
+inline HC12PacketAwaiter HC12::ReadPacketAsync()
+{
+    return HC12PacketAwaiter(*this);
+}
+
+#endif // HC12_HAS_COROUTINES
+
+#endif // INCLUDE_ARDUINO_HC12_ASYNC_H
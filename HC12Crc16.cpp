@@ -0,0 +1,103 @@
+/**
+ * @file HC12Crc16.cpp
+ * @author Giel Willemsen
+ * @brief Implementation of the CRC-16 used to protect frames send with the HC12.
+ * @version 0.1 2026-10-17 Initial version of CRC-16/CCITT-FALSE with a small nibble table.
+ * @version 0.2 2026-10-17 Added slice-by-8 fast path for host builds.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include "HC12Crc16.h"
+
+// A table per nibble instead of per byte, 32 bytes instead of 512 bytes.
+static const uint16_t kNibbleTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+uint16_t HC12Crc16::UpdateSmall(uint16_t crc, const uint8_t *data, size_t size)
+{
+    while (size-- > 0)
+    {
+        uint8_t value = *data++;
+        crc = (uint16_t)((crc << 4) ^ kNibbleTable[(crc >> 12) ^ (value >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ kNibbleTable[(crc >> 12) ^ (value & 0x0F)]);
+    }
+    return crc;
+}
+
+#if HC12_CRC_SLICE_BY_8
+
+/**
+ * @brief The slice-by-8 tables, table k holds the CRC of a byte followed by k zero bytes.
+ *
+ */
+struct SliceTables
+{
+    uint16_t table[8][256];
+
+    SliceTables()
+    {
+        for (uint16_t i = 0; i < 256; i++)
+        {
+            uint16_t crc = (uint16_t)(i << 8);
+            for (uint8_t bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+            }
+            this->table[0][i] = crc;
+        }
+        for (uint8_t slice = 1; slice < 8; slice++)
+        {
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                uint16_t previous = this->table[slice - 1][i];
+                this->table[slice][i] = (uint16_t)((previous << 8) ^ this->table[0][previous >> 8]);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Get the slice-by-8 tables, filled on first use.
+ * @details A function-local static instead of a file-scope object, so a CRC computed during the static
+ * initialization of another translation unit doesn't run on tables that are still all zero.
+ *
+ * @return const SliceTables& The filled tables.
+ */
+static const SliceTables &GetSliceTables()
+{
+    static const SliceTables tables;
+    return tables;
+}
+
+uint16_t HC12Crc16::Update(uint16_t crc, const uint8_t *data, size_t size)
+{
+    const uint16_t(&table)[8][256] = GetSliceTables().table;
+    while (size >= 8)
+    {
+        crc = table[7][data[0] ^ (crc >> 8)] ^
+              table[6][data[1] ^ (crc & 0xFF)] ^
+              table[5][data[2]] ^
+              table[4][data[3]] ^
+              table[3][data[4]] ^
+              table[2][data[5]] ^
+              table[1][data[6]] ^
+              table[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+    // The tail that doesn't fill a whole slice.
+    return UpdateSmall(crc, data, size);
+}
+
+#else
+
+uint16_t HC12Crc16::Update(uint16_t crc, const uint8_t *data, size_t size)
+{
+    return UpdateSmall(crc, data, size);
+}
+
+#endif // HC12_CRC_SLICE_BY_8
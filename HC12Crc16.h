@@ -0,0 +1,69 @@
+/**
+ * @file HC12Crc16.h
+ * @author Giel Willemsen
+ * @brief CRC-16 used to protect frames send with the HC12.
+ * @version 0.1 2026-10-17 Initial version of CRC-16/CCITT-FALSE with a small nibble table.
+ * @version 0.2 2026-10-17 Added slice-by-8 fast path for host builds.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_CRC16_H
+#define INCLUDE_ARDUINO_HC12_CRC16_H
+
+#include "Arduino.h"
+
+/**
+ * @brief Use 4 KiB of slice-by-8 tables (8 bytes per step) instead of the 32 byte nibble table (half a byte per step).
+ * @details Enabled by default on host builds (without `ARDUINO`), where the gateway checks the frames of many radios.
+ * Define it as 1 to also use it on a microcontroller with enough RAM, like the ESP32.
+ *
+ */
+#ifndef HC12_CRC_SLICE_BY_8
+#ifdef ARDUINO
+#define HC12_CRC_SLICE_BY_8 0
+#else
+#define HC12_CRC_SLICE_BY_8 1
+#endif
+#endif
+
+/**
+ * @brief CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF, no reflection or final xor).
+ * @details The CRC is appended high byte first, so the CRC over a frame including its CRC is always 0.
+ *
+ */
+class HC12Crc16
+{
+public:
+    /**
+     * @brief The value to start a new CRC calculation with.
+     *
+     */
+    static constexpr uint16_t kInitial = 0xFFFF;
+
+    /**
+     * @brief Add data to a running CRC calculation.
+     *
+     * @param crc The CRC so far (start with `kInitial`).
+     * @param data The data to add.
+     * @param size The amount of bytes to add.
+     * @return uint16_t The new CRC value.
+     */
+    static uint16_t Update(uint16_t crc, const uint8_t *data, size_t size);
+
+    /**
+     * @brief Add data to a running CRC calculation using only the small nibble table.
+     * @details Gives the exact same result as `Update`, which uses this for the tail or when the slice-by-8 tables
+     * are disabled.
+     *
+     * @param crc The CRC so far (start with `kInitial`).
+     * @param data The data to add.
+     * @param size The amount of bytes to add.
+     * @return uint16_t The new CRC value.
+     */
+    static uint16_t UpdateSmall(uint16_t crc, const uint8_t *data, size_t size);
+};
+
+#endif // INCLUDE_ARDUINO_HC12_CRC16_H
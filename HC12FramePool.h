@@ -0,0 +1,192 @@
+/**
+ * @file HC12FramePool.h
+ * @author Giel Willemsen
+ * @brief Fixed block frame allocator for the protocol layers on top of the HC12.
+ * @version 0.1 2026-10-17 Initial version with O(1) allocate/free, checked reference counts and usage statistics.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_FRAME_POOL_H
+#define INCLUDE_ARDUINO_HC12_FRAME_POOL_H
+
+#include "Arduino.h"
+
+/**
+ * @brief Pool of equally sized frames that are allocated at compile time, so no heap is needed.
+ * @details Allocating and releasing a frame is O(1) by keeping the free frames on a stack of indices.
+ * A frame can be shared (for example between a retransmit and a relay queue) by calling `Retain`,
+ * it returns to the pool when the last owner calls `Release`.
+ *
+ * @tparam kFrameCount The amount of frames in the pool (max 255).
+ * @tparam kFrameSize The size of the data of each frame in bytes.
+ */
+template <uint8_t kFrameCount, size_t kFrameSize>
+class HC12FramePool
+{
+    static_assert(kFrameCount > 0, "The frame pool needs at least one frame.");
+    static_assert(kFrameSize > 0, "The frames need to be able to hold at least one byte.");
+
+public:
+    /**
+     * @brief A single frame from the pool.
+     *
+     */
+    struct Frame
+    {
+        uint8_t data[kFrameSize];
+        size_t length;
+    };
+
+    /**
+     * @brief Usage statistics of the pool.
+     *
+     */
+    struct Stats
+    {
+        uint8_t inUse;
+        uint8_t highWaterMark;
+        unsigned long allocations;
+        unsigned long failures;
+    };
+
+    /**
+     * @brief The amount of frames in the pool.
+     *
+     */
+    static constexpr uint8_t kCapacity = kFrameCount;
+
+    /**
+     * @brief The size of the data of each frame in bytes.
+     *
+     */
+    static constexpr size_t kSize = kFrameSize;
+
+private:
+    Frame frames[kFrameCount];
+    uint8_t refCounts[kFrameCount];
+    uint8_t freeList[kFrameCount];
+    uint8_t freeCount;
+    Stats stats;
+
+public:
+    HC12FramePool() : freeCount(kFrameCount), stats{0, 0, 0, 0}
+    {
+        for (uint8_t i = 0; i < kFrameCount; i++)
+        {
+            this->refCounts[i] = 0;
+            this->freeList[i] = kFrameCount - 1 - i;
+        }
+    }
+
+    /**
+     * @brief Take a frame from the pool, it starts with a reference count of 1 and a length of 0.
+     *
+     * @return Frame* The frame or `nullptr` if the pool is empty.
+     */
+    Frame *Allocate()
+    {
+        if (this->freeCount == 0)
+        {
+            this->stats.failures++;
+            return nullptr;
+        }
+        uint8_t index = this->freeList[--this->freeCount];
+        this->refCounts[index] = 1;
+        this->frames[index].length = 0;
+
+        this->stats.allocations++;
+        this->stats.inUse++;
+        if (this->stats.inUse > this->stats.highWaterMark)
+        {
+            this->stats.highWaterMark = this->stats.inUse;
+        }
+        return &this->frames[index];
+    }
+
+    /**
+     * @brief Add an owner to the frame.
+     *
+     * @param frame The frame that is shared.
+     * @return true If the owner was added.
+     * @return false If the frame is free (it could be allocated to someone else) or already has 255 owners.
+     */
+    bool Retain(Frame *frame)
+    {
+        if (frame == nullptr)
+        {
+            return false;
+        }
+        uint8_t index = this->IndexOf(frame);
+        if (this->refCounts[index] == 0 || this->refCounts[index] == UINT8_MAX)
+        {
+            return false;
+        }
+        this->refCounts[index]++;
+        return true;
+    }
+
+    /**
+     * @brief Remove an owner from the frame, the frame goes back to the pool when it was the last one.
+     *
+     * @param frame The frame to release, `nullptr` is ignored.
+     */
+    void Release(Frame *frame)
+    {
+        if (frame == nullptr)
+        {
+            return;
+        }
+        uint8_t index = this->IndexOf(frame);
+        if (this->refCounts[index] == 0)
+        {
+            return;
+        }
+        if (--this->refCounts[index] == 0)
+        {
+            this->freeList[this->freeCount++] = index;
+            this->stats.inUse--;
+        }
+    }
+
+    /**
+     * @brief Get the amount of owners of the frame.
+     *
+     * @param frame The frame to check.
+     * @return uint8_t The reference count, 0 if the frame is free.
+     */
+    uint8_t RefCount(const Frame *frame) const
+    {
+        return this->refCounts[this->IndexOf(frame)];
+    }
+
+    /**
+     * @brief Get the amount of frames that can still be allocated.
+     *
+     * @return uint8_t The amount of free frames.
+     */
+    uint8_t Available() const
+    {
+        return this->freeCount;
+    }
+
+    /**
+     * @brief Get the usage statistics of the pool.
+     *
+     * @return Stats The statistics.
+     */
+    Stats GetStats() const
+    {
+        return this->stats;
+    }
+
+private:
+    uint8_t IndexOf(const Frame *frame) const
+    {
+        return (uint8_t)(frame - this->frames);
+    }
+};
+
+#endif // INCLUDE_ARDUINO_HC12_FRAME_POOL_H
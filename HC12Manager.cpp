@@ -0,0 +1,90 @@
+/**
+ * @file HC12Manager.cpp
+ * @author Giel Willemsen
+ * @brief Implementation of the manager that drives multiple HC12 modules at the same time.
+ * @version 0.1 2026-10-17 Initial version that interleaves the command sessions and data pumps of all radios.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include "HC12Manager.h"
+
+HC12Manager::HC12Manager() : radios{}, radioCount(0), firstRadio(0)
+{
+}
+
+bool HC12Manager::Add(HC12 &radio)
+{
+    if (this->radioCount == HC12_MANAGER_MAX_RADIOS)
+    {
+        return false;
+    }
+    this->radios[this->radioCount++] = &radio;
+    return true;
+}
+
+uint8_t HC12Manager::Count() const
+{
+    return this->radioCount;
+}
+
+HC12 &HC12Manager::operator[](uint8_t index)
+{
+    return *this->radios[index];
+}
+
+void HC12Manager::poll()
+{
+    for (uint8_t i = 0; i < this->radioCount; i++)
+    {
+        this->radios[(this->firstRadio + i) % this->radioCount]->poll();
+    }
+    if (this->radioCount > 0)
+    {
+        this->firstRadio = (this->firstRadio + 1) % this->radioCount;
+    }
+}
+
+bool HC12Manager::BeginUpdateParams(uint8_t index, HC12::Deadline deadline)
+{
+    if (index >= this->radioCount)
+    {
+        return false;
+    }
+    return this->radios[index]->BeginUpdateParams(deadline);
+}
+
+bool HC12Manager::UpdateAllParams(HC12::Deadline deadline)
+{
+    bool success = true;
+    bool started[HC12_MANAGER_MAX_RADIOS];
+    for (uint8_t i = 0; i < this->radioCount; i++)
+    {
+        started[i] = this->radios[i]->BeginUpdateParams(deadline);
+        success = success && started[i];
+    }
+    while (this->IsCommandBusy())
+    {
+        this->poll();
+        yield();
+    }
+    for (uint8_t i = 0; i < this->radioCount; i++)
+    {
+        success = success && started[i] && this->radios[i]->LastCommandSucceeded();
+    }
+    return success;
+}
+
+bool HC12Manager::IsCommandBusy() const
+{
+    for (uint8_t i = 0; i < this->radioCount; i++)
+    {
+        if (this->radios[i]->IsCommandBusy())
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file HC12Manager.h
+ * @author Giel Willemsen
+ * @brief Drives multiple HC12 modules at the same time.
+ * @version 0.1 2026-10-17 Initial version that interleaves the command sessions and data pumps of all radios.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_MANAGER_H
+#define INCLUDE_ARDUINO_HC12_MANAGER_H
+
+#include "Arduino.h"
+#include "HC12.h"
+
+/**
+ * @brief Maximum amount of radios a single manager can drive.
+ *
+ */
+#ifndef HC12_MANAGER_MAX_RADIOS
+#define HC12_MANAGER_MAX_RADIOS 4
+#endif
+
+/**
+ * @brief Drives several HC12 modules from one loop without one radio ever blocking another.
+ * @details All command mode operations are started with the non-blocking `Begin*` calls of `HC12`, so while one
+ * radio is being reconfigured the others keep receiving and sending in the same `poll()`.
+ *
+ */
+class HC12Manager
+{
+private:
+    HC12 *radios[HC12_MANAGER_MAX_RADIOS];
+    uint8_t radioCount;
+    uint8_t firstRadio;
+
+public:
+    HC12Manager();
+
+    /**
+     * @brief Add a radio to be driven by this manager. The radio must outlive the manager.
+     *
+     * @param radio The radio to add.
+     * @return true If the radio was added.
+     * @return false If the manager is full (`HC12_MANAGER_MAX_RADIOS`).
+     */
+    bool Add(HC12 &radio);
+
+    /**
+     * @brief Get the amount of radios in the manager.
+     *
+     * @return uint8_t The amount of radios.
+     */
+    uint8_t Count() const;
+
+    /**
+     * @brief Get one of the radios.
+     *
+     * @param index The index of the radio, in the order they were added.
+     * @return HC12& The radio.
+     */
+    HC12 &operator[](uint8_t index);
+
+    /**
+     * @brief Poll every radio once. The radio that goes first rotates, so no radio always has to wait for all others.
+     *
+     */
+    void poll();
+
+    /**
+     * @brief Start updating the parameters of a single radio, without blocking the others.
+     *
+     * @param index The index of the radio.
+     * @param deadline The time the session must have finished by.
+     * @return true If the session was started.
+     * @return false If the index is invalid, the radio is busy or there isn't enough time.
+     */
+    bool BeginUpdateParams(uint8_t index, HC12::Deadline deadline = HC12::Deadline::Never());
+
+    /**
+     * @brief Update the parameters of all radios at the same time, while still polling all of them.
+     *
+     * @param deadline The time all sessions must have finished by.
+     * @return true If every radio was updated.
+     * @return false If a radio failed or didn't finish in time.
+     */
+    bool UpdateAllParams(HC12::Deadline deadline = HC12::Deadline::Never());
+
+    /**
+     * @brief Check if any of the radios is running a command mode session.
+     *
+     * @return true If at least one radio is busy.
+     * @return false If all radios are in their normal mode.
+     */
+    bool IsCommandBusy() const;
+};
+
+#endif // INCLUDE_ARDUINO_HC12_MANAGER_H
@@ -0,0 +1,220 @@
+/**
+ * @file HC12PubSub.cpp
+ * @author Giel Willemsen
+ * @brief Implementation of the publish/subscribe layer on top of the HC12 framing.
+ * @version 0.1 2026-10-17 Initial version with 1 byte topics, a subscription table and a last value cache.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include "HC12PubSub.h"
+
+HC12PubSub::HC12PubSub(HC12 &radio) : radio(radio), subscriptions{}, cache{}, cacheSequence(0), stats{0, 0, 0, 0},
+                                      registered(false)
+{
+}
+
+HC12PubSub::~HC12PubSub()
+{
+    this->end();
+}
+
+bool HC12PubSub::begin()
+{
+    if (!this->registered)
+    {
+        this->registered = this->radio.onPacket(&HC12PubSub::OnPacket, this);
+    }
+    return this->registered;
+}
+
+void HC12PubSub::end()
+{
+    if (this->registered)
+    {
+        this->radio.RemoveHandler(&HC12PubSub::OnPacket, this);
+        this->registered = false;
+    }
+}
+
+bool HC12PubSub::Publish(uint8_t topic, const uint8_t *data, size_t length, uint8_t priority)
+{
+    if (length > HC12::kMaxFrameSize - kOverhead)
+    {
+        return false;
+    }
+    HC12::WriteSpan spans[] = {{&topic, 1}, {data, length}};
+    return this->radio.Enqueue(spans, 2, priority, true);
+}
+
+bool HC12PubSub::Subscribe(uint8_t topic, MessageHandler handler, void *context)
+{
+    if (handler == nullptr)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < HC12_PUBSUB_MAX_SUBSCRIPTIONS; i++)
+    {
+        Subscription &subscription = this->subscriptions[i];
+        if (subscription.handler == nullptr)
+        {
+            subscription.handler = handler;
+            subscription.context = context;
+            subscription.topic = topic;
+
+            HC12::FrameView value;
+            if (this->GetCached(topic, value))
+            {
+                handler(topic, value, context);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HC12PubSub::Unsubscribe(uint8_t topic, MessageHandler handler, void *context)
+{
+    for (uint8_t i = 0; i < HC12_PUBSUB_MAX_SUBSCRIPTIONS; i++)
+    {
+        Subscription &subscription = this->subscriptions[i];
+        if (subscription.handler == handler && subscription.context == context && subscription.topic == topic)
+        {
+            subscription.handler = nullptr;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HC12PubSub::GetCached(uint8_t topic, HC12::FrameView &value) const
+{
+    const CacheSlot *slot = this->FindCached(topic);
+    if (slot == nullptr)
+    {
+        return false;
+    }
+    value.first = slot->data;
+    value.firstLength = slot->length;
+    value.second = nullptr;
+    value.secondLength = 0;
+    return true;
+}
+
+HC12PubSub::Stats HC12PubSub::GetStats() const
+{
+    return this->stats;
+}
+
+void HC12PubSub::OnPacket(const HC12::FrameView &frame, void *context)
+{
+    static_cast<HC12PubSub *>(context)->HandleFrame(frame);
+}
+
+HC12::FrameView HC12PubSub::Slice(const HC12::FrameView &frame, size_t offset, size_t length)
+{
+    HC12::FrameView slice;
+    if (offset < frame.firstLength)
+    {
+        size_t available = frame.firstLength - offset;
+        slice.first = frame.first + offset;
+        slice.firstLength = (length < available) ? length : available;
+        slice.second = frame.second;
+        slice.secondLength = length - slice.firstLength;
+    }
+    else
+    {
+        slice.first = frame.second + (offset - frame.firstLength);
+        slice.firstLength = length;
+        slice.second = nullptr;
+        slice.secondLength = 0;
+    }
+    return slice;
+}
+
+void HC12PubSub::HandleFrame(const HC12::FrameView &frame)
+{
+    if (frame.Size() < kOverhead || !frame.HasValidCrc())
+    {
+        this->stats.crcErrors++;
+        return;
+    }
+    this->stats.received++;
+    uint8_t topic = frame[0];
+    HC12::FrameView payload = Slice(frame, 1, frame.Size() - kOverhead);
+    this->Store(topic, payload);
+
+    // Subscriptions added by a handler already got the cached value, so only call the ones that were there before.
+    bool active[HC12_PUBSUB_MAX_SUBSCRIPTIONS];
+    for (uint8_t i = 0; i < HC12_PUBSUB_MAX_SUBSCRIPTIONS; i++)
+    {
+        active[i] = this->subscriptions[i].handler != nullptr && this->subscriptions[i].topic == topic;
+    }
+    for (uint8_t i = 0; i < HC12_PUBSUB_MAX_SUBSCRIPTIONS; i++)
+    {
+        const Subscription &subscription = this->subscriptions[i];
+        if (active[i] && subscription.handler != nullptr)
+        {
+            subscription.handler(topic, payload, subscription.context);
+            this->stats.delivered++;
+        }
+    }
+}
+
+void HC12PubSub::Store(uint8_t topic, const HC12::FrameView &payload)
+{
+    CacheSlot *slot = const_cast<CacheSlot *>(this->FindCached(topic));
+    if (payload.Size() > HC12_PUBSUB_CACHE_SIZE)
+    {
+        // A stale value is worse than none.
+        if (slot != nullptr)
+        {
+            slot->used = false;
+        }
+        return;
+    }
+    if (slot == nullptr)
+    {
+        slot = &this->cache[0];
+        for (uint8_t i = 0; i < HC12_PUBSUB_CACHE_SLOTS; i++)
+        {
+            CacheSlot &candidate = this->cache[i];
+            if (!candidate.used)
+            {
+                slot = &candidate;
+                break;
+            }
+            if (candidate.sequence < slot->sequence)
+            {
+                slot = &candidate;
+            }
+        }
+        if (slot->used)
+        {
+            this->stats.cacheEvictions++;
+        }
+    }
+    memcpy(slot->data, payload.first, payload.firstLength);
+    if (payload.secondLength > 0)
+    {
+        memcpy(slot->data + payload.firstLength, payload.second, payload.secondLength);
+    }
+    slot->length = (uint8_t)payload.Size();
+    slot->topic = topic;
+    slot->used = true;
+    slot->sequence = ++this->cacheSequence;
+}
+
+const HC12PubSub::CacheSlot *HC12PubSub::FindCached(uint8_t topic) const
+{
+    for (uint8_t i = 0; i < HC12_PUBSUB_CACHE_SLOTS; i++)
+    {
+        if (this->cache[i].used && this->cache[i].topic == topic)
+        {
+            return &this->cache[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file HC12PubSub.h
+ * @author Giel Willemsen
+ * @brief Topic based publish/subscribe on top of the HC12 framing.
+ * @version 0.1 2026-10-17 Initial version with 1 byte topics, a subscription table and a last value cache.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_PUBSUB_H
+#define INCLUDE_ARDUINO_HC12_PUBSUB_H
+
+#include "Arduino.h"
+#include "HC12.h"
+
+/**
+ * @brief Maximum amount of subscriptions.
+ *
+ */
+#ifndef HC12_PUBSUB_MAX_SUBSCRIPTIONS
+#define HC12_PUBSUB_MAX_SUBSCRIPTIONS 8
+#endif
+
+/**
+ * @brief Amount of topics whose last value is kept.
+ *
+ */
+#ifndef HC12_PUBSUB_CACHE_SLOTS
+#define HC12_PUBSUB_CACHE_SLOTS 4
+#endif
+
+/**
+ * @brief Maximum size of a value in the last value cache, bigger messages are delivered but not cached.
+ *
+ */
+#ifndef HC12_PUBSUB_CACHE_SIZE
+#define HC12_PUBSUB_CACHE_SIZE 16
+#endif
+
+/**
+ * @brief Publish/subscribe on 1 byte topics over a HC12.
+ * @details Every message is a single frame of `[topic][payload][CRC-16]`. Received messages with a valid CRC are
+ * handed to every subscription of their topic, and the last value of each topic is kept in a fixed amount of slots.
+ * A new subscription is called with the cached value right away, so it doesn't have to wait for the next publish.
+ * When all slots are taken the topic that was updated the longest ago is replaced.
+ *
+ */
+class HC12PubSub
+{
+public:
+    /**
+     * @brief Called with the payload (without topic and CRC) of a message.
+     *
+     */
+    typedef void (*MessageHandler)(uint8_t topic, const HC12::FrameView &payload, void *context);
+
+    /**
+     * @brief Counters of the received messages.
+     *
+     */
+    struct Stats
+    {
+        unsigned long received;
+        unsigned long delivered;
+        unsigned long crcErrors;
+        unsigned long cacheEvictions;
+    };
+
+    /**
+     * @brief The amount of bytes the topic and CRC add to every message.
+     *
+     */
+    static constexpr size_t kOverhead = 3;
+
+private:
+    struct Subscription
+    {
+        MessageHandler handler;
+        void *context;
+        uint8_t topic;
+    };
+
+    struct CacheSlot
+    {
+        uint8_t data[HC12_PUBSUB_CACHE_SIZE];
+        uint8_t length;
+        uint8_t topic;
+        bool used;
+        unsigned long sequence;
+    };
+
+    HC12 &radio;
+    Subscription subscriptions[HC12_PUBSUB_MAX_SUBSCRIPTIONS];
+    CacheSlot cache[HC12_PUBSUB_CACHE_SLOTS];
+    unsigned long cacheSequence;
+    Stats stats;
+    bool registered;
+
+public:
+    HC12PubSub(HC12 &radio);
+    ~HC12PubSub();
+
+    /**
+     * @brief Start receiving messages by adding a packet handler to the radio.
+     *
+     * @return true If the handler was added (or already was).
+     * @return false If the handler table of the radio is full.
+     */
+    bool begin();
+
+    /**
+     * @brief Stop receiving messages, the subscriptions and cache are kept.
+     *
+     */
+    void end();
+
+    /**
+     * @brief Queue a message for a topic.
+     *
+     * @param topic The topic to publish on.
+     * @param data The payload.
+     * @param length The size of the payload (max `HC12::kMaxFrameSize` - `kOverhead` bytes).
+     * @param priority The priority in the transmit queues of the radio.
+     * @return true If the message was queued.
+     * @return false If the payload is too big or the queue is full.
+     */
+    bool Publish(uint8_t topic, const uint8_t *data, size_t length, uint8_t priority = HC12::kLowestPriority);
+
+    /**
+     * @brief Call a handler for every message on a topic, starting with the cached value if there is one.
+     *
+     * @param topic The topic to subscribe to.
+     * @param handler The function to call.
+     * @param context Passed to the handler as is.
+     * @return true If the subscription was added.
+     * @return false If the subscription table (`HC12_PUBSUB_MAX_SUBSCRIPTIONS`) is full.
+     */
+    bool Subscribe(uint8_t topic, MessageHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Remove a subscription.
+     *
+     * @param topic The topic it was subscribed to.
+     * @param handler The function that was given to `Subscribe`.
+     * @param context The context that was given to `Subscribe`.
+     * @return true If the subscription was removed.
+     * @return false If there was no such subscription.
+     */
+    bool Unsubscribe(uint8_t topic, MessageHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Get the last received value of a topic.
+     *
+     * @param topic The topic.
+     * @param value Set to the cached payload, valid until the next `poll()` of the radio.
+     * @return true If the topic has a cached value.
+     * @return false If nothing was received for the topic, or it didn't fit or was evicted from the cache.
+     */
+    bool GetCached(uint8_t topic, HC12::FrameView &value) const;
+
+    /**
+     * @brief Get the counters of the received messages.
+     *
+     * @return Stats The counters.
+     */
+    Stats GetStats() const;
+
+private:
+    static void OnPacket(const HC12::FrameView &frame, void *context);
+    static HC12::FrameView Slice(const HC12::FrameView &frame, size_t offset, size_t length);
+    void HandleFrame(const HC12::FrameView &frame);
+    void Store(uint8_t topic, const HC12::FrameView &payload);
+    const CacheSlot *FindCached(uint8_t topic) const;
+};
+
+#endif // INCLUDE_ARDUINO_HC12_PUBSUB_H
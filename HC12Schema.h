@@ -0,0 +1,222 @@
+/**
+ * @file HC12Schema.h
+ * @author Giel Willemsen
+ * @brief Compile time description of bit packed payloads send with the HC12.
+ * @version 0.1 2026-10-17 Initial version with constexpr wire size, bit packed encoding and zero copy decoding.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_SCHEMA_H
+#define INCLUDE_ARDUINO_HC12_SCHEMA_H
+
+#include "Arduino.h"
+
+/**
+ * @brief A single field of a schema.
+ * @details Only integer, bool and enum types are supported. Signed values are sign extended when decoded.
+ *
+ * @tparam T The type of the field in the application.
+ * @tparam kBits The amount of bits the field takes on air (1 to 32).
+ */
+template <typename T, uint8_t kBits = sizeof(T) * 8>
+struct HC12Field
+{
+    static_assert(kBits > 0 && kBits <= 32, "A field takes between 1 and 32 bits.");
+    typedef T Type;
+    static constexpr uint8_t kBitCount = kBits;
+};
+
+/**
+ * @brief The total amount of bits of a list of fields.
+ *
+ */
+template <typename... Fields>
+struct HC12SchemaBits;
+
+template <>
+struct HC12SchemaBits<>
+{
+    static constexpr size_t kValue = 0;
+};
+
+template <typename First, typename... Rest>
+struct HC12SchemaBits<First, Rest...>
+{
+    static constexpr size_t kValue = First::kBitCount + HC12SchemaBits<Rest...>::kValue;
+};
+
+/**
+ * @brief The field at an index in a list of fields, and its offset in bits.
+ *
+ */
+template <size_t kIndex, typename... Fields>
+struct HC12SchemaField;
+
+template <typename First, typename... Rest>
+struct HC12SchemaField<0, First, Rest...>
+{
+    typedef First Field;
+    static constexpr size_t kOffset = 0;
+};
+
+template <size_t kIndex, typename First, typename... Rest>
+struct HC12SchemaField<kIndex, First, Rest...>
+{
+    typedef typename HC12SchemaField<kIndex - 1, Rest...>::Field Field;
+    static constexpr size_t kOffset = First::kBitCount + HC12SchemaField<kIndex - 1, Rest...>::kOffset;
+};
+
+/**
+ * @brief Describes a payload as a list of fields that are packed bit by bit, without any padding.
+ * @details The fields are stored in the order they are declared, most significant bit first, so the encoding is the
+ * same on every architecture. Decoding reads straight from the source (a buffer or a `HC12::FrameView`), nothing is
+ * copied first.
+ *
+ * @code
+ * typedef HC12Schema<HC12Field<uint8_t, 4>,    // Sensor id
+ *                    HC12Field<int16_t, 12>,   // Temperature in 0.1 degrees
+ *                    HC12Field<bool, 1>> Telemetry;
+ * uint8_t buffer[Telemetry::kWireSize];         // 3 bytes instead of a padded struct
+ * Telemetry::Encode(buffer, 3, -125, true);
+ * int16_t temperature = Telemetry::Decode<1>(frame);
+ * @endcode
+ *
+ * @tparam Fields The `HC12Field`s of the payload.
+ */
+template <typename... Fields>
+class HC12Schema
+{
+public:
+    /**
+     * @brief The amount of fields.
+     *
+     */
+    static constexpr size_t kFieldCount = sizeof...(Fields);
+
+    /**
+     * @brief The amount of bits all the fields take together.
+     *
+     */
+    static constexpr size_t kBitCount = HC12SchemaBits<Fields...>::kValue;
+
+    /**
+     * @brief The amount of bytes the payload takes on air.
+     *
+     */
+    static constexpr size_t kWireSize = (kBitCount + 7) / 8;
+
+    /**
+     * @brief The application type of the field at an index.
+     *
+     */
+    template <size_t kIndex>
+    using FieldType = typename HC12SchemaField<kIndex, Fields...>::Field::Type;
+
+    /**
+     * @brief Pack the values into a buffer.
+     *
+     * @param buffer The buffer to write into, at least `kWireSize` bytes.
+     * @param values A value for every field, in order.
+     * @return size_t The amount of bytes written (`kWireSize`).
+     */
+    static size_t Encode(uint8_t *buffer, typename Fields::Type... values)
+    {
+        memset(buffer, 0, kWireSize);
+        EncodeFrom<0>(buffer, values...);
+        return kWireSize;
+    }
+
+    /**
+     * @brief Read a single field straight from a source without unpacking the others.
+     *
+     * @tparam kIndex The index of the field.
+     * @tparam Source A byte pointer or anything with a byte `operator[]` (like `HC12::FrameView`).
+     * @param source The data to read from.
+     * @param byteOffset Where the payload starts in the source (for example after a header).
+     * @return FieldType<kIndex> The value of the field.
+     */
+    template <size_t kIndex, typename Source>
+    static FieldType<kIndex> Decode(const Source &source, size_t byteOffset = 0)
+    {
+        typedef HC12SchemaField<kIndex, Fields...> Info;
+        typedef typename Info::Field::Type Type;
+        const uint8_t kBits = Info::Field::kBitCount;
+        uint32_t value = ReadBits(source, byteOffset * 8 + Info::kOffset, kBits);
+        // Sign extend when the type is signed and the highest encoded bit is set.
+        if ((Type)-1 < (Type)0 && kBits < 32 && (value & (1UL << (kBits - 1))) != 0)
+        {
+            value |= ~((1UL << kBits) - 1);
+        }
+        return (Type)value;
+    }
+
+    /**
+     * @brief A typed view on an encoded payload, fields are only read when asked for.
+     *
+     * @tparam Source A byte pointer or anything with a byte `operator[]` (like `HC12::FrameView`).
+     */
+    template <typename Source>
+    class View
+    {
+    private:
+        Source source;
+        size_t byteOffset;
+
+    public:
+        View(const Source &source, size_t byteOffset = 0) : source(source), byteOffset(byteOffset)
+        {}
+
+        template <size_t kIndex>
+        FieldType<kIndex> Get() const
+        {
+            return HC12Schema::Decode<kIndex>(this->source, this->byteOffset);
+        }
+    };
+
+private:
+    template <size_t kIndex>
+    static void EncodeFrom(uint8_t *)
+    {}
+
+    template <size_t kIndex, typename Value, typename... Rest>
+    static void EncodeFrom(uint8_t *buffer, Value value, Rest... rest)
+    {
+        typedef HC12SchemaField<kIndex, Fields...> Info;
+        WriteBits(buffer, Info::kOffset, Info::Field::kBitCount, (uint32_t)value);
+        EncodeFrom<kIndex + 1>(buffer, rest...);
+    }
+
+    static void WriteBits(uint8_t *buffer, size_t offset, uint8_t bits, uint32_t value)
+    {
+        while (bits > 0)
+        {
+            uint8_t used = offset % 8;
+            uint8_t count = (bits < 8 - used) ? bits : 8 - used;
+            uint8_t part = (uint8_t)((value >> (bits - count)) & ((1U << count) - 1));
+            buffer[offset / 8] |= (uint8_t)(part << (8 - used - count));
+            offset += count;
+            bits -= count;
+        }
+    }
+
+    template <typename Source>
+    static uint32_t ReadBits(const Source &source, size_t offset, uint8_t bits)
+    {
+        uint32_t value = 0;
+        while (bits > 0)
+        {
+            uint8_t used = offset % 8;
+            uint8_t count = (bits < 8 - used) ? bits : 8 - used;
+            uint8_t part = (uint8_t)((source[offset / 8] >> (8 - used - count)) & ((1U << count) - 1));
+            value = (value << count) | part;
+            offset += count;
+            bits -= count;
+        }
+        return value;
+    }
+};
+
+#endif // INCLUDE_ARDUINO_HC12_SCHEMA_H
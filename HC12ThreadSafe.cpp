@@ -0,0 +1,195 @@
+/**
+ * @file HC12ThreadSafe.cpp
+ * @author Giel Willemsen
+ * @brief Implementation of the front end that lets multiple tasks or threads share one HC12.
+ * @version 0.1 2026-10-17 Initial version with a lock-free multi producer queue drained by one owner task, that refuses frames and parameters the radio can never accept and enters command mode once the air is idle.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <Arduino.h>
+#include "HC12ThreadSafe.h"
+
+#ifdef HC12_THREAD_SAFE_AVAILABLE
+
+HC12ThreadSafe::HC12ThreadSafe(HC12 &radio) : radio(radio), enqueuePosition(0), dequeuePosition(0)
+{
+    for (size_t i = 0; i < HC12_THREAD_SAFE_SLOTS; i++)
+    {
+        this->slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool HC12ThreadSafe::Write(const uint8_t *buffer, size_t size, uint8_t priority)
+{
+    // A frame the radio can never queue would block every request behind it, so refuse it here.
+    if (size == 0 || size > HC12_THREAD_SAFE_SLOT_SIZE || size > HC12::kMaxFrameSize ||
+        priority > HC12::kLowestPriority)
+    {
+        return false;
+    }
+    return this->Push(RequestType::Data, buffer, size, priority, 0);
+}
+
+bool HC12ThreadSafe::PrepareBaudrate(HC12::Baudrates baudrate)
+{
+    if (!HC12::IsBaudrate(baudrate))
+    {
+        return false;
+    }
+    return this->Push(RequestType::PrepareBaudrate, nullptr, 0, 0, (int)baudrate);
+}
+
+bool HC12ThreadSafe::PrepareOperationalMode(HC12::OperationalMode mode)
+{
+    if (!HC12::IsOperationalMode(mode))
+    {
+        return false;
+    }
+    return this->Push(RequestType::PrepareOperationalMode, nullptr, 0, 0, (int)mode);
+}
+
+bool HC12ThreadSafe::PrepareChannel(int channel)
+{
+    if (!HC12::IsChannel(channel))
+    {
+        return false;
+    }
+    return this->Push(RequestType::PrepareChannel, nullptr, 0, 0, channel);
+}
+
+bool HC12ThreadSafe::PrepareTransmitPower(HC12::TransmitPower power)
+{
+    if (!HC12::IsTransmitPower(power))
+    {
+        return false;
+    }
+    return this->Push(RequestType::PrepareTransmitPower, nullptr, 0, 0, (int)power);
+}
+
+bool HC12ThreadSafe::RequestUpdateParams()
+{
+    return this->Push(RequestType::UpdateParams, nullptr, 0, 0, 0);
+}
+
+bool HC12ThreadSafe::RequestSleep()
+{
+    return this->Push(RequestType::Sleep, nullptr, 0, 0, 0);
+}
+
+bool HC12ThreadSafe::RequestReset()
+{
+    return this->Push(RequestType::Reset, nullptr, 0, 0, 0);
+}
+
+void HC12ThreadSafe::Pump()
+{
+    this->radio.poll();
+    while (!this->radio.IsCommandBusy())
+    {
+        Slot &slot = this->slots[this->dequeuePosition % HC12_THREAD_SAFE_SLOTS];
+        if (slot.sequence.load(std::memory_order_acquire) != this->dequeuePosition + 1)
+        {
+            // Nothing (completely) queued yet.
+            return;
+        }
+        if (!this->Process(slot))
+        {
+            // The radio can't take it yet, try again on the next pump so the order is kept.
+            return;
+        }
+        slot.sequence.store(this->dequeuePosition + HC12_THREAD_SAFE_SLOTS, std::memory_order_release);
+        this->dequeuePosition++;
+    }
+}
+
+bool HC12ThreadSafe::Push(RequestType type, const uint8_t *buffer, size_t size, uint8_t priority, int value)
+{
+    // Bounded multi producer queue where each slot carries a sequence number that tells whose turn it is.
+    size_t position = this->enqueuePosition.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true)
+    {
+        slot = &this->slots[position % HC12_THREAD_SAFE_SLOTS];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            if (this->enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if ((intptr_t)(sequence - position) < 0)
+        {
+            // The consumer hasn't freed this slot yet, so the queue is full.
+            return false;
+        }
+        else
+        {
+            position = this->enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->type = type;
+    slot->priority = priority;
+    slot->value = value;
+    slot->length = size;
+    if (size > 0)
+    {
+        memcpy(slot->data, buffer, size);
+    }
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool HC12ThreadSafe::Process(Slot &slot)
+{
+    switch (slot.type)
+    {
+    case RequestType::Data:
+        return this->radio.Enqueue(slot.data, slot.length, slot.priority);
+    case RequestType::PrepareBaudrate:
+        this->radio.PrepareBaudrate((HC12::Baudrates)slot.value);
+        return true;
+    case RequestType::PrepareOperationalMode:
+        this->radio.PrepareOperationalMode((HC12::OperationalMode)slot.value);
+        return true;
+    case RequestType::PrepareChannel:
+        this->radio.PrepareChannel(slot.value);
+        return true;
+    case RequestType::PrepareTransmitPower:
+        this->radio.PrepareTransmitPower((HC12::TransmitPower)slot.value);
+        return true;
+    case RequestType::UpdateParams:
+        if (!this->IsAirIdle())
+        {
+            return false;
+        }
+        this->radio.BeginUpdateParams();
+        return true;
+    case RequestType::Sleep:
+        if (!this->IsAirIdle())
+        {
+            return false;
+        }
+        this->radio.BeginSleep();
+        return true;
+    case RequestType::Reset:
+        if (!this->IsAirIdle())
+        {
+            return false;
+        }
+        this->radio.BeginReset();
+        return true;
+    }
+    return true;
+}
+
+bool HC12ThreadSafe::IsAirIdle()
+{
+    // Every frame that was handed over before the command must be queued out and send before SET may go low.
+    return this->radio.IsTransmitQueueEmpty() && this->radio.airFlush();
+}
+
+#endif // HC12_THREAD_SAFE_AVAILABLE
@@ -0,0 +1,138 @@
+/**
+ * @file HC12ThreadSafe.h
+ * @author Giel Willemsen
+ * @brief Front end that lets multiple tasks or threads share one HC12.
+ * @version 0.1 2026-10-17 Initial version with a lock-free multi producer queue drained by one owner task, that refuses frames and parameters the radio can never accept and enters command mode once the air is idle.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_THREAD_SAFE_H
+#define INCLUDE_ARDUINO_HC12_THREAD_SAFE_H
+
+#include "Arduino.h"
+#include "HC12.h"
+
+// Only platforms with <atomic> (like the ESP32 or a host build) can use the thread safe front end.
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define HC12_THREAD_SAFE_AVAILABLE 1
+#endif
+#endif
+
+#ifdef HC12_THREAD_SAFE_AVAILABLE
+#include <atomic>
+
+/**
+ * @brief Amount of requests (frames or commands) that can be waiting for the owner task.
+ *
+ */
+#ifndef HC12_THREAD_SAFE_SLOTS
+#define HC12_THREAD_SAFE_SLOTS 16
+#endif
+
+/**
+ * @brief Maximum size of a single frame that is written through the front end.
+ *
+ */
+#ifndef HC12_THREAD_SAFE_SLOT_SIZE
+#define HC12_THREAD_SAFE_SLOT_SIZE 64
+#endif
+
+/**
+ * @brief Lets any task write frames and request configuration changes, while only one owner task touches the HC12.
+ * @details Requests go through a bounded lock-free multi producer queue. The owner task calls `Pump()`, which hands
+ * the requests in order to the HC12. A command mode request is only started once all frames that were written before
+ * it are queued and have left the module (`airFlush()`), and no later frame is handed over until the command mode
+ * session has finished. So a task calling `RequestUpdateParams()` can never pull the SET pin low in the middle of
+ * another task's write.
+ *
+ */
+class HC12ThreadSafe
+{
+private:
+    enum class RequestType : uint8_t
+    {
+        Data,
+        PrepareBaudrate,
+        PrepareOperationalMode,
+        PrepareChannel,
+        PrepareTransmitPower,
+        UpdateParams,
+        Sleep,
+        Reset
+    };
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        RequestType type;
+        uint8_t priority;
+        int value;
+        size_t length;
+        uint8_t data[HC12_THREAD_SAFE_SLOT_SIZE];
+    };
+
+    HC12 &radio;
+    Slot slots[HC12_THREAD_SAFE_SLOTS];
+    std::atomic<size_t> enqueuePosition;
+    size_t dequeuePosition;
+
+public:
+    /**
+     * @brief Construct the front end for a radio. After this only the owner task may use the radio directly.
+     *
+     * @param radio The radio to share.
+     */
+    HC12ThreadSafe(HC12 &radio);
+
+    /**
+     * @brief Queue a frame to be send. Can be called from any task.
+     *
+     * @param buffer The data of the frame.
+     * @param size The size of the frame (max `HC12_THREAD_SAFE_SLOT_SIZE` and `HC12::kMaxFrameSize`).
+     * @param priority The priority the frame gets in the HC12 transmit queues (up to `HC12::kLowestPriority`).
+     * @return true If the frame was queued.
+     * @return false If the frame is too big, the priority is invalid or the queue is full.
+     */
+    bool Write(const uint8_t *buffer, size_t size, uint8_t priority = HC12::kLowestPriority);
+
+    /**
+     * @brief Request a new baudrate for the next `RequestUpdateParams()`. Can be called from any task.
+     *
+     * @return true If the request was queued.
+     * @return false If the value is invalid or the queue is full.
+     */
+    bool PrepareBaudrate(HC12::Baudrates baudrate);
+    bool PrepareOperationalMode(HC12::OperationalMode mode);
+    bool PrepareChannel(int channel);
+    bool PrepareTransmitPower(HC12::TransmitPower power);
+
+    /**
+     * @brief Request a command mode session. Can be called from any task, the result is reported through the
+     * `onCommandComplete` handlers of the radio (called from the owner task).
+     *
+     * @return true If the request was queued.
+     * @return false If the queue is full.
+     */
+    bool RequestUpdateParams();
+    bool RequestSleep();
+    bool RequestReset();
+
+    /**
+     * @brief Hand the queued requests to the radio and poll it. Must only be called from the owner task.
+     *
+     */
+    void Pump();
+
+private:
+    bool Push(RequestType type, const uint8_t *buffer, size_t size, uint8_t priority, int value);
+    bool Process(Slot &slot);
+    bool IsAirIdle();
+};
+
+#endif // HC12_THREAD_SAFE_AVAILABLE
+
+#endif // INCLUDE_ARDUINO_HC12_THREAD_SAFE_H
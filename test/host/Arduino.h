@@ -0,0 +1,18 @@
+/**
+ * @file Arduino.h
+ * @author Giel Willemsen
+ * @brief The part of the Arduino core that the host checks need, to build them without an Arduino toolchain.
+ * @version 0.1 2026-10-17 Initial version with the fixed width integer types.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#ifndef INCLUDE_ARDUINO_HC12_TEST_HOST_ARDUINO_H
+#define INCLUDE_ARDUINO_HC12_TEST_HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#endif // INCLUDE_ARDUINO_HC12_TEST_HOST_ARDUINO_H
@@ -0,0 +1,89 @@
+/**
+ * @file HC12Crc16Check.cpp
+ * @author Giel Willemsen
+ * @brief Host check that the slice-by-8 CRC gives the exact same result as the nibble table.
+ * @details Build and run it from the root of the library:
+ * `g++ -std=gnu++11 -Wall -Itest/host -I. test/host/HC12Crc16Check.cpp HC12Crc16.cpp -o crc16_check && ./crc16_check`
+ * @version 0.1 2026-10-17 Initial version comparing all lengths, offsets and start values, and the static init order.
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <stdio.h>
+#include <Arduino.h>
+#include "HC12Crc16.h"
+
+#if !HC12_CRC_SLICE_BY_8
+#error "The host check compares the slice-by-8 path, build it with HC12_CRC_SLICE_BY_8 set to 1."
+#endif
+
+static const uint8_t kCheckInput[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+// The standard check value of CRC-16/CCITT-FALSE over "123456789".
+static const uint16_t kCheckValue = 0x29B1;
+
+// Computed during static initialization, before anything in HC12Crc16.cpp is guaranteed to be initialized.
+static const uint16_t staticInitCrc = HC12Crc16::Update(HC12Crc16::kInitial, kCheckInput, sizeof(kCheckInput));
+
+static unsigned int failures = 0;
+
+static void Check(bool condition, const char *what, size_t size, size_t offset, uint16_t start)
+{
+    if (!condition)
+    {
+        failures++;
+        printf("FAIL %s (size %u, offset %u, start 0x%04X)\n", what, (unsigned int)size, (unsigned int)offset,
+               (unsigned int)start);
+    }
+}
+
+int main()
+{
+    Check(staticInitCrc == kCheckValue, "CRC during static init", sizeof(kCheckInput), 0, HC12Crc16::kInitial);
+    Check(HC12Crc16::Update(HC12Crc16::kInitial, kCheckInput, sizeof(kCheckInput)) == kCheckValue,
+          "check value", sizeof(kCheckInput), 0, HC12Crc16::kInitial);
+
+    // Pseudo random data, so every table entry gets used.
+    uint8_t data[300];
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        state = state * 1103515245UL + 12345UL;
+        data[i] = (uint8_t)(state >> 16);
+    }
+
+    // Every offset within a slice, every length around and across multiple slices and a few start values.
+    const uint16_t starts[] = {HC12Crc16::kInitial, 0x0000, 0x1D0F, 0x8001};
+    for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++)
+    {
+        for (size_t offset = 0; offset < 8; offset++)
+        {
+            for (size_t size = 0; size + offset <= sizeof(data); size++)
+            {
+                uint16_t fast = HC12Crc16::Update(starts[s], data + offset, size);
+                uint16_t small = HC12Crc16::UpdateSmall(starts[s], data + offset, size);
+                Check(fast == small, "slice-by-8 differs from nibble table", size, offset, starts[s]);
+            }
+        }
+    }
+
+    // Appending the CRC high byte first gives a CRC of 0 over the whole frame.
+    uint8_t frame[sizeof(kCheckInput) + 2];
+    for (size_t i = 0; i < sizeof(kCheckInput); i++)
+    {
+        frame[i] = kCheckInput[i];
+    }
+    frame[sizeof(kCheckInput)] = (uint8_t)(kCheckValue >> 8);
+    frame[sizeof(kCheckInput) + 1] = (uint8_t)(kCheckValue & 0xFF);
+    Check(HC12Crc16::Update(HC12Crc16::kInitial, frame, sizeof(frame)) == 0, "CRC over frame with CRC",
+          sizeof(frame), 0, HC12Crc16::kInitial);
+
+    if (failures == 0)
+    {
+        printf("HC12Crc16: all checks passed\n");
+        return 0;
+    }
+    printf("HC12Crc16: %u checks failed\n", failures);
+    return 1;
+}